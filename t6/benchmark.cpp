@@ -0,0 +1,219 @@
+#include "virtual_disc.h"
+#include <chrono>
+#include <map>
+
+struct BenchmarkResult{
+    std::string name;
+    std::map<std::string, u_int64_t> parameters;
+    u_int64_t iterations;
+    double seconds;
+    u_int64_t bytes;
+};
+
+std::vector<BenchmarkResult> results;
+std::string disc_name = "benchmark_disc";
+OpenMode open_mode = OpenMode::MMAP_MODE;
+const char* mode_names[] = {"stream", "mmap", "cache", "lazy"};
+IOBackend io_backend = IOBackend::SYNC_IO;
+IOBackend used_io_backend = IOBackend::SYNC_IO;
+const char* io_backend_names[] = {"sync", "threads", "uring"};
+
+double measure(std::function<void()> operation){
+    auto start = std::chrono::steady_clock::now();
+    operation();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+double measure_quiet(std::function<void()> operation){
+    std::ofstream null_stream("/dev/null");
+    std::streambuf *output = std::cout.rdbuf(null_stream.rdbuf());
+    double seconds = measure(operation);
+    std::cout.rdbuf(output);
+    return seconds;
+}
+
+void setup_disc(VirtualDisc &disc){
+    disc.set_open_mode(open_mode);
+    disc.set_io_backend(io_backend, QUEUE_DEPTH, false);
+    used_io_backend = disc.get_io_backend();
+}
+
+void add_result(std::string name, std::map<std::string, u_int64_t> parameters, u_int64_t iterations, double seconds, u_int64_t bytes = 0){
+    results.push_back(BenchmarkResult{name, parameters, iterations, seconds, bytes});
+}
+
+void create_host_file(std::string file_name, u_int64_t size){
+    std::ofstream file(file_name, std::ios::binary | std::ios::trunc);
+    std::vector<char> buffer(DATA_BLOCK_SIZE);
+    for(u_int64_t idx = 0; idx < buffer.size(); idx++)
+        buffer[idx] = (char)(idx * 31 + 7);
+    for(u_int64_t written = 0; written < size; written += buffer.size())
+        file.write(buffer.data(), std::min<u_int64_t>(buffer.size(), size - written));
+}
+
+void benchmark_create_open_close(u_int64_t disc_size){
+    VirtualDisc disc;
+    setup_disc(disc);
+    add_result("create", {{"disc_size", disc_size}}, 1, measure([&](){ disc.create(disc_name, disc_size); }));
+    const u_int64_t iterations = 20;
+    double open_seconds = 0, close_seconds = 0;
+    for(u_int64_t idx = 0; idx < iterations; idx++){
+        open_seconds += measure([&](){ disc.open(); });
+        close_seconds += measure([&](){ disc.close(); });
+    }
+    add_result("open", {{"disc_size", disc_size}}, iterations, open_seconds);
+    add_result("close", {{"disc_size", disc_size}}, iterations, close_seconds);
+}
+
+void benchmark_mkdir(u_int64_t depth, u_int64_t width){
+    VirtualDisc disc;
+    setup_disc(disc);
+    disc.create(disc_name, 256 << 20);
+    disc.open();
+    std::vector<std::string> paths;
+    for(u_int64_t idx = 0; idx < width; idx++){
+        std::string path = "w" + std::to_string(idx);
+        for(u_int64_t level = 1; level < depth; level++)
+            path += "/d";
+        paths.push_back(path);
+    }
+    double seconds = measure([&](){
+        for(auto &path : paths)
+            disc.create_directory(path);
+    });
+    disc.close();
+    add_result("mkdir", {{"depth", depth}, {"width", width}}, width, seconds);
+}
+
+void benchmark_send_get(u_int64_t file_size){
+    const std::string file_name = "bench_file";
+    const std::string file_name_destination = "bench_file_out";
+    u_int64_t iterations = std::min<u_int64_t>(256, std::max<u_int64_t>(4, (64 << 20) / file_size));
+    create_host_file(file_name, file_size);
+    VirtualDisc disc;
+    setup_disc(disc);
+    disc.create(disc_name, 256 << 20);
+    disc.open();
+    for(u_int64_t idx = 0; idx < iterations; idx++)
+        disc.create_directory(std::to_string(idx));
+    double send_seconds = measure([&](){
+        for(u_int64_t idx = 0; idx < iterations; idx++)
+            disc.file_to_disc(std::to_string(idx), file_name);
+        disc.sync();
+    });
+    double get_seconds = measure([&](){
+        for(u_int64_t idx = 0; idx < iterations; idx++)
+            disc.file_from_disc(std::to_string(idx) + "/" + file_name, file_name_destination);
+        disc.sync();
+    });
+    disc.close();
+    unlink(file_name.c_str());
+    unlink(file_name_destination.c_str());
+    add_result("send", {{"file_size", file_size}}, iterations, send_seconds, iterations * file_size);
+    add_result("get", {{"file_size", file_size}}, iterations, get_seconds, iterations * file_size);
+}
+
+void benchmark_lookup(u_int64_t entries){
+    const u_int64_t iterations = 10000;
+    VirtualDisc disc;
+    setup_disc(disc);
+    disc.create(disc_name, 64 << 20);
+    disc.open();
+    for(u_int64_t idx = 0; idx < entries; idx++)
+        disc.create_directory("big/e" + std::to_string(idx));
+    disc.close();
+    disc.open();
+    double cold_seconds = measure([&](){
+        for(u_int64_t idx = 0; idx < iterations; idx++){
+            disc.clear_path_cache();
+            disc.get_size("big/e" + std::to_string(idx * 7919 % entries));
+        }
+    });
+    double warm_seconds = measure([&](){
+        for(u_int64_t idx = 0; idx < iterations; idx++)
+            disc.get_size("big/e" + std::to_string(idx * 7919 % entries));
+    });
+    disc.close();
+    add_result("lookup_cold", {{"entries", entries}}, iterations, cold_seconds);
+    add_result("lookup_warm", {{"entries", entries}}, iterations, warm_seconds);
+}
+
+void create_tree(VirtualDisc &disc, std::string path, u_int64_t fanout, u_int64_t depth){
+    if(depth == 0)
+        return;
+    for(u_int64_t idx = 0; idx < fanout; idx++){
+        std::string child = path + "/n" + std::to_string(idx);
+        disc.create_directory(child);
+        create_tree(disc, child, fanout, depth - 1);
+    }
+}
+
+void benchmark_tree_ls(u_int64_t fanout, u_int64_t depth){
+    const u_int64_t iterations = 5;
+    VirtualDisc disc;
+    setup_disc(disc);
+    disc.create(disc_name, 256 << 20);
+    disc.open();
+    create_tree(disc, "t", fanout, depth);
+    disc.close();
+    disc.open();
+    double tree_seconds = measure_quiet([&](){
+        for(u_int64_t idx = 0; idx < iterations; idx++)
+            disc.show_files_tree("t");
+    });
+    double ls_seconds = measure_quiet([&](){
+        for(u_int64_t idx = 0; idx < iterations; idx++)
+            disc.show_information("t");
+    });
+    disc.close();
+    add_result("tree", {{"fanout", fanout}, {"depth", depth}}, iterations, tree_seconds);
+    add_result("ls", {{"fanout", fanout}, {"depth", depth}}, iterations, ls_seconds);
+}
+
+void print_results(){
+    std::cout << "{\n  \"mode\": \"" << mode_names[open_mode] << "\",\n  \"io\": \"" << io_backend_names[used_io_backend] << "\",\n  \"benchmarks\": [\n";
+    for(u_int64_t idx = 0; idx < results.size(); idx++){
+        BenchmarkResult &result = results[idx];
+        std::cout << "    {\"name\": \"" << result.name << "\", \"parameters\": {";
+        for(auto it = result.parameters.begin(); it != result.parameters.end(); it++)
+            std::cout << (it == result.parameters.begin() ? "" : ", ") << "\"" << it->first << "\": " << it->second;
+        std::cout << "}, \"iterations\": " << result.iterations << ", \"seconds\": " << result.seconds;
+        std::cout << ", \"operations_per_second\": " << (result.seconds > 0 ? result.iterations / result.seconds : 0);
+        if(result.bytes)
+            std::cout << ", \"bytes_per_second\": " << (result.seconds > 0 ? result.bytes / result.seconds : 0);
+        std::cout << "}" << (idx + 1 < results.size() ? "," : "") << "\n";
+    }
+    std::cout << "  ]\n}\n";
+}
+
+int main(int argc, char* argv[]){
+    if(argc > 1)
+        disc_name = argv[1];
+    const char* mode = getenv("VIRTUAL_DISC_MODE");
+    if(mode && std::string(mode) == "stream")
+        open_mode = OpenMode::STREAM_MODE;
+    else if(mode && std::string(mode) == "cache")
+        open_mode = OpenMode::CACHE_MODE;
+    else if(mode && std::string(mode) == "lazy")
+        open_mode = OpenMode::LAZY_MODE;
+    const char* backend = getenv("VIRTUAL_DISC_IO");
+    if(backend && std::string(backend) == "threads")
+        io_backend = IOBackend::THREADS_IO;
+    else if(backend && std::string(backend) == "uring")
+        io_backend = IOBackend::URING_IO;
+
+    for(u_int64_t disc_size : {16ull << 20, 256ull << 20})
+        benchmark_create_open_close(disc_size);
+    for(u_int64_t depth : {1, 8, 32})
+        for(u_int64_t width : {16, 256})
+            benchmark_mkdir(depth, width);
+    for(u_int64_t file_size : {4ull << 10, 64ull << 10, 1ull << 20, 16ull << 20})
+        benchmark_send_get(file_size);
+    for(u_int64_t entries : {100, 1000, 10000})
+        benchmark_lookup(entries);
+    for(u_int64_t fanout : {4, 8})
+        benchmark_tree_ls(fanout, 4);
+    unlink(disc_name.c_str());
+    print_results();
+    return 0;
+}
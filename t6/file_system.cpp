@@ -1,687 +1,4 @@
-#include <stdio.h>
-#include <stdlib.h>
-#include <iostream>
-#include <vector>
-#include <algorithm>
-#include <string.h>
-#include <string>
-#include <unordered_map>
-#include <functional>
-#include <fstream>
-
-
-#define DATA_BLOCK_SIZE 8192
-#define NAME_LENGTH 16
-#define FILES_SPACE 8
-#define DIRECTORY_LINKS_IN_DATA_BLOCK (DATA_BLOCK_SIZE / sizeof(DirectoryLink))
-
-#pragma region structures
-
-enum INodeType{
-    UNUSED_NODE,
-    FILE_NODE,
-    DIRECTORY_NODE
-};
-
-struct INode{
-    u_int64_t size;
-    u_int64_t data_block_index;
-
-    u_int8_t type;
-    u_int8_t reference_count;
-};
-
-struct DataBlock{
-    u_int64_t offset;
-
-    u_int8_t data[DATA_BLOCK_SIZE];
-};
-
-struct DirectoryLink{
-    u_int16_t inode_id;
-
-    u_int8_t used;
-    u_int8_t name[NAME_LENGTH];
-};
-
-struct SuperBlock{
-    u_int64_t disc_size;
-    u_int64_t inode_offset;
-    u_int64_t data_map_offset;
-    u_int64_t data_block_offset;
-
-    u_int32_t unused_inodes;
-    u_int32_t inodes_count;
-    u_int32_t unused_datablocks;
-    u_int32_t datablocks_count;
-
-    u_int8_t name[NAME_LENGTH];
-};
-
-#pragma endregion
-
-
-class VirtualDisc{
-private:
-    std::string name;
-    FILE* file;
-    INode *inodes;
-    bool *data_maps;
-    DataBlock *data_blocks;
-    SuperBlock super_block;
-    u_int64_t inodes_length;
-    u_int64_t data_maps_length;
-    u_int64_t data_blocks_length;
-    std::vector<DirectoryLink*> shown_direcotry_links;
-    std::vector<INode*> shown_inodes;
-
-
-public:
-    void create(std::string file_name, u_int64_t disc_size){
-        name = file_name;
-        std::ofstream file(file_name, std::ios::out | std::ios::binary);
-        if(!file){
-            std::cout << "Cannot open file";
-            exit(EXIT_FAILURE);
-        }
-
-        u_int64_t number_of_inodes = disc_size / sizeof(INode) / FILES_SPACE;
-        u_int64_t max_number_of_data_blocks = (disc_size - sizeof(SuperBlock) - number_of_inodes * sizeof(INode)) / sizeof(DataBlock);
-        u_int64_t number_of_data_blocks = (disc_size - sizeof(SuperBlock) - number_of_inodes * sizeof(INode) - max_number_of_data_blocks * sizeof(bool)) / sizeof(DataBlock);
-        u_int64_t data_map_offset = sizeof(SuperBlock) + number_of_inodes * sizeof(INode);
-        u_int64_t data_block_offset = data_map_offset + number_of_data_blocks * sizeof(bool);
-
-        strncpy((char*)super_block.name, name.c_str(), NAME_LENGTH);
-        super_block.disc_size = disc_size;
-        super_block.inodes_count = number_of_inodes;
-        super_block.unused_inodes = number_of_inodes;
-        super_block.datablocks_count = number_of_data_blocks;
-        super_block.unused_datablocks = number_of_data_blocks;
-        super_block.inode_offset = sizeof(SuperBlock);
-        super_block.data_map_offset = data_map_offset;
-        super_block.data_block_offset = data_block_offset;
-
-        load_lengths(super_block);
-
-        INode root{};
-        root.type = INodeType::DIRECTORY_NODE;
-        root.data_block_index = -1;
-        root.reference_count = 1;
-        super_block.unused_inodes -= 1;
-
-        file.write((char*)&super_block, sizeof(SuperBlock));
-        file.write((char*)&root, sizeof(INode));
-
-        for(u_int64_t i = 0; i < inodes_length - 1; i++){
-            INode inode{};
-            inode.data_block_index = -1;
-            file.write((char*)&inode, sizeof(INode));
-        }
-
-        for(u_int64_t i = 0; i < data_maps_length; i++){
-            unsigned int idx;
-            file.write((char*)&idx, sizeof(bool));
-        }
-
-        for(u_int64_t i = 0; i < data_blocks_length; i++){
-            DataBlock data_block{};
-            data_block.offset = -1;
-            file.write((char*)&data_block, sizeof(DataBlock));
-        }
-
-        file.close();
-        if(!file.good()){
-            std::cout << "Writing to file error";
-            exit(EXIT_FAILURE);
-        }
-    }
-
-    void open(){
-        std::ifstream file(name, std::ios::out | std::ios::binary);
-        if(!file){
-            std::cout << "Cannot open file";
-            exit(EXIT_FAILURE);
-        }
-        file.read((char*)&super_block, sizeof(SuperBlock));
-        load_lengths(super_block);
-        inodes = new INode[inodes_length];
-        for(u_int64_t i = 0; i < inodes_length; i++)
-            file.read((char*)&inodes[i], sizeof(INode));
-        data_maps = new bool[data_maps_length];
-        for(u_int64_t i = 0; i < data_maps_length; i++)
-            file.read((char*)&data_maps[i], sizeof(bool));
-        data_blocks = new DataBlock[data_blocks_length];
-        for(u_int64_t i = 0; i < data_blocks_length; i++)
-            file.read((char*)&data_blocks[i], sizeof(DataBlock));
-        file.close();
-        if(!file.good()){
-            std::cout << "Reagin from file error";
-            exit(EXIT_FAILURE);
-        }
-    }
-
-    void close(){
-        std::ofstream file(name, std::ios::out | std::ios::binary);
-        if(!file){
-            std::cout << "Cannot open file";
-            exit(EXIT_FAILURE);
-        }
-        file.write((char*)&super_block, sizeof(SuperBlock));
-        for(u_int64_t i = 0; i < inodes_length; i++)
-            file.write((char*)&inodes[i], sizeof(INode));
-        for(u_int64_t i = 0; i < data_maps_length; i++)
-            file.write((char*)&data_maps[i], sizeof(bool));
-        for(u_int64_t i = 0; i < data_blocks_length; i++)
-            file.write((char*)&data_blocks[i], sizeof(DataBlock));
-        file.close();
-        if(!file.good()){
-            std::cout << "Writing to file error";
-            exit(EXIT_FAILURE);
-        }
-    }
-
-    void set_name(std::string file_name){
-        name = file_name;
-    }
-
-    void create_directory(std::string pwd){
-        std::vector<std::string> directories = split_pwd(pwd);
-        INode *current_direcotry_inode = inodes;
-        for(auto current_directory_name : directories){
-            if(!is_valid_name(current_directory_name)){
-                std::cerr << "Invalid directory name: " << current_directory_name << "\n";
-                exit(EXIT_FAILURE);
-            }
-            INode* next_direcotry_inode = get_inode_in_inode(current_direcotry_inode, current_directory_name);
-            if(next_direcotry_inode && next_direcotry_inode->type == INodeType::DIRECTORY_NODE){
-                current_direcotry_inode = next_direcotry_inode;
-            } else if (next_direcotry_inode){
-                std::cerr << "Missing directory: " << next_direcotry_inode << "\n";
-                return;
-            } else{
-                u_int64_t new_inode_idx = get_empty_inode();
-                inodes[new_inode_idx].reference_count = 1;
-                inodes[new_inode_idx].type = INodeType::DIRECTORY_NODE;
-
-                DirectoryLink new_directory_link{};
-                new_directory_link.used = true;
-                new_directory_link.inode_id = new_inode_idx;
-                strncpy((char *)new_directory_link.name, current_directory_name.c_str(), NAME_LENGTH);
-
-                if(current_direcotry_inode->data_block_index == (u_int64_t)-1){
-                    u_int64_t new_data_block_idx = get_empty_data_block();
-                    current_direcotry_inode->data_block_index = new_data_block_idx;
-                    *(DirectoryLink*)data_blocks[new_data_block_idx].data = new_directory_link;
-                    data_maps[new_data_block_idx] = true;
-                } else{
-                    add_link_to_inode(current_direcotry_inode, new_directory_link);
-                }
-                current_direcotry_inode = &inodes[new_inode_idx];
-            }
-        }
-    }
-
-    void show_files_tree(std::string pwd){
-        shown_direcotry_links.clear();
-        std::vector<std::string> path = split_pwd(pwd);
-        INode *directory = get_direcotry_inode(path);
-        if(!directory){
-            std::cerr << "Invalid path\n";
-            exit(EXIT_FAILURE);
-        }
-        return show_files_inode(directory, 0);
-    }
-
-    void file_to_disc(std::string pwd, std::string file_name){
-        std::vector<std::string> path = split_pwd(pwd);
-        INode *direcotry_inode = get_direcotry_inode(path);
-        if(!direcotry_inode){
-            std::cerr << "Invalid path";
-            exit(EXIT_FAILURE);
-        }
-        if(get_inode_in_inode(direcotry_inode, file_name)){
-            std::cerr << "FIle alraedy exists";
-            exit(EXIT_FAILURE);
-        }
-
-        u_int64_t new_inode_idx = get_empty_inode();
-        inodes[new_inode_idx].reference_count = 1;
-        inodes[new_inode_idx].type = INodeType::FILE_NODE;
-        inodes[new_inode_idx].size = 0;
-
-        DirectoryLink new_file_link{};
-        new_file_link.used = true;
-        new_file_link.inode_id = new_inode_idx;
-        strncpy((char *)new_file_link.name, file_name.c_str(), NAME_LENGTH);
-
-        add_link_to_inode(direcotry_inode, new_file_link);
-
-        std::ifstream file(file_name, std::ios::out | std::ios::binary);
-        if(!file){
-            std::cout << "Cannot open file";
-            exit(EXIT_FAILURE);
-        }
-
-        inodes[new_inode_idx].data_block_index = get_empty_data_block();
-        u_int64_t current_data_block_idx = inodes[new_inode_idx].data_block_index;
-        while(current_data_block_idx != (u_int64_t)-1){
-            unsigned left_size_in_block = 0;
-            while(left_size_in_block < DATA_BLOCK_SIZE){
-                file.read((char*)&data_blocks[current_data_block_idx].data, DATA_BLOCK_SIZE - left_size_in_block);
-                if(!file.gcount() && file.eof())
-                    break;
-                else if (!file.gcount()){
-                    std::cerr << "Invalid file";
-                    exit(EXIT_FAILURE);
-                }
-                left_size_in_block += file.gcount();
-                inodes[new_inode_idx].size += file.gcount();
-            }
-            if(!left_size_in_block){
-                remove_data_block_from_inode(&inodes[new_inode_idx], current_data_block_idx);
-                current_data_block_idx = -1;
-            } else if (file.eof()){
-                data_maps[current_data_block_idx] = true;
-                data_blocks[current_data_block_idx].offset = -1;
-                current_data_block_idx = -1;
-            } else {
-                data_maps[current_data_block_idx] = true;
-                data_blocks[current_data_block_idx].offset = get_empty_data_block();
-                current_data_block_idx = data_blocks[current_data_block_idx].offset;
-            }
-        }
-    }
-
-    void file_from_disc(std::string pwd, std::string file_name_destination){
-        INode* file = get_inode_by_pwd(pwd);
-        std::ofstream file_destination(file_name_destination, std::ios::out | std::ios::binary);
-        if(!file){
-            std::cout << "Cannot open file";
-            exit(EXIT_FAILURE);
-        }
-        u_int64_t current_data_block_idx = file->data_block_index;
-        u_int64_t left_size = file->size;
-        u_int64_t current_size = 0;
-        while(current_data_block_idx != (u_int64_t)-1){
-            u_int8_t *data = data_blocks[current_data_block_idx].data;
-            if(left_size < DATA_BLOCK_SIZE)
-                current_size = left_size;
-            else
-                current_size = DATA_BLOCK_SIZE;
-            file_destination.write((char*)data, current_size);
-            left_size -= current_size;
-            current_data_block_idx = data_blocks[current_data_block_idx].offset;
-        }
-        file_destination.close();
-        if(!file_destination.good()){
-            std::cout << "Writing to file error";
-            exit(EXIT_FAILURE);
-        }
-    }
-
-    u_int64_t get_left_space(){
-        u_int64_t left_space = 0;
-        for(u_int64_t i = 0; i < data_blocks_length; i++)
-            if(data_maps[i] == false)
-                left_space += DATA_BLOCK_SIZE;
-        return left_space;
-    }
-
-    u_int64_t get_size(std::string pwd){
-        std::vector<std::string> path = split_pwd(pwd);
-        INode *direcotry = get_direcotry_inode(path);
-        u_int64_t size = 0;
-        u_int64_t current_data_block_idx = direcotry->data_block_index;
-        while(current_data_block_idx != (u_int64_t)-1){
-            DirectoryLink* direcotry_links = (DirectoryLink*)data_blocks[current_data_block_idx].data;
-            for(u_int64_t idx = 0; idx < DIRECTORY_LINKS_IN_DATA_BLOCK; idx++){
-                if(direcotry_links[idx].used)
-                   size += inodes[direcotry_links[idx].inode_id].size;
-            }
-            current_data_block_idx = data_blocks[current_data_block_idx].offset;
-        }
-        return size;
-    }
-
-    u_int64_t get_full_size(std::string pwd){
-        std::vector<std::string> path = split_pwd(pwd);
-        shown_inodes.clear();
-        INode *directory = get_direcotry_inode(path);
-        return get_size_inode(directory);
-    }
-
-    void create_link(std::string pwd, std::string link_pwd){
-        INode* file = get_inode_by_pwd(pwd);
-        std::vector<std::string> link_path = split_pwd(link_pwd);
-        std::string link_file_name = link_path.back();
-        link_path.pop_back();
-        INode *link_directory_inode = get_direcotry_inode(link_path);
-        if(!link_directory_inode){
-            std::cerr << "Invalid path";
-            exit(EXIT_FAILURE);
-        }
-        file->reference_count += 1;
-        DirectoryLink new_file_link{};
-        new_file_link.used = true;
-        new_file_link.inode_id = file - inodes;
-        strncpy((char *)new_file_link.name, link_file_name.c_str(), NAME_LENGTH);
-        add_link_to_inode(link_directory_inode, new_file_link);
-    }
-
-    void show_information(std::string pwd){
-        std::cout << "Information about: \x1B[34m" << pwd << "\033[0m\n";
-        std::cout << "Files size: \x1B[33m" << get_size(pwd) << "\033[0m\n";
-        std::cout << "Full size: \x1B[33m" << get_full_size(pwd) << "\033[0m\n";
-        std::cout << "Left space: \x1B[33m" << get_left_space() << "\033[0m\n";
-    }
-
-    void remove_link(std::string pwd){
-        std::vector<std::string> path = split_pwd(pwd);
-        std::string file_name = path.back();
-        path.pop_back();
-        INode *direcotry_inode = get_direcotry_inode(path);
-        if(!direcotry_inode){
-            std::cerr << "Invalid path";
-            exit(EXIT_FAILURE);
-        }
-        INode *file= get_inode_in_inode(direcotry_inode, file_name);
-        if(!file){
-            std::cerr << "Missing file";
-            exit(EXIT_FAILURE);
-        }
-        remove_inode(file);
-        DirectoryLink *direcotry_link = get_direcotry_in_inode(direcotry_inode, file_name);
-        direcotry_link->inode_id = -1;
-        direcotry_link->used = false;
-    }
-
-    void cut_file(std::string pwd , size_t size_to_cut){
-        INode* file = get_inode_by_pwd(pwd);
-        if(file->size < size_to_cut){
-            std::cerr << "Size to cut greater than file's size";
-            exit(EXIT_FAILURE);
-        }
-        file->size -= size_to_cut;
-        u_int64_t start_cut_block = file->size / DATA_BLOCK_SIZE;
-        if(file->size % DATA_BLOCK_SIZE != 0)
-            start_cut_block++;
-        u_int64_t data_block_idx = file->data_block_index;
-        u_int64_t prev_data_block_idx = -1;
-        for(u_int64_t idx = 0; idx < start_cut_block; idx++){
-            prev_data_block_idx = data_block_idx;
-            data_block_idx = data_blocks[idx].offset;
-        }
-        clear_datablocks(data_block_idx);
-        if(prev_data_block_idx == (u_int64_t)-1)
-            file->data_block_index = -1;
-        else
-            data_blocks[prev_data_block_idx].offset = -1;
-    }
-
-    void extend_file(std::string pwd, size_t size_to_extend){
-        INode* file = get_inode_by_pwd(pwd);
-        u_int64_t last_datablock_idx = file->data_block_index;
-        while(data_blocks[last_datablock_idx].offset != (u_int64_t)-1)
-            last_datablock_idx = data_blocks[last_datablock_idx].offset;
-
-        u_int64_t last_datablock_size = file->size % DATA_BLOCK_SIZE;
-        if(last_datablock_size > 0){
-            u_int64_t current_size_to_extend = DATA_BLOCK_SIZE - (file->size % DATA_BLOCK_SIZE);
-            if(current_size_to_extend > size_to_extend)
-                current_size_to_extend = size_to_extend;
-            memset(data_blocks[last_datablock_idx].data + last_datablock_size * sizeof(u_int8_t), 0, current_size_to_extend);
-            size_to_extend -= current_size_to_extend;
-            file->size += current_size_to_extend;
-        }
-        while(size_to_extend > 0){
-            data_blocks[last_datablock_idx].offset = get_empty_data_block();
-            if(data_blocks[last_datablock_idx].offset == (u_int64_t)-1){
-                std::cerr << "Invalid path";
-                exit(EXIT_FAILURE);
-            }
-            data_maps[data_blocks[last_datablock_idx].offset] = true;
-            u_int64_t new_size;
-            if(size_to_extend > DATA_BLOCK_SIZE)
-                new_size = DATA_BLOCK_SIZE;
-            else
-                new_size = size_to_extend;
-            memset(data_blocks[data_blocks[last_datablock_idx].offset].data, 0, new_size);
-            size_to_extend -= new_size;
-            file->size += new_size;
-            last_datablock_idx = data_blocks[last_datablock_idx].offset;
-        }
-    }
-
-private:
-    bool is_valid_name(std::string name){
-        if(name.length() >= NAME_LENGTH or name == "." or name == ".." or name == "/")
-            return false;
-        return true;
-    }
-
-    INode* get_inode_by_pwd(std::string pwd){
-        std::vector<std::string> path = split_pwd(pwd);
-        std::string file_name = path.back();
-        path.pop_back();
-        INode *direcotry_inode = get_direcotry_inode(path);
-        if(!direcotry_inode){
-            std::cerr << "Invalid path";
-            exit(EXIT_FAILURE);
-        }
-        INode *file= get_inode_in_inode(direcotry_inode, file_name);
-        if(!file){
-            std::cerr << "Missing file";
-            exit(EXIT_FAILURE);
-        }
-        return file;
-    }
-
-    u_int32_t get_empty_inode(){
-        for(u_int32_t i = 0; i < inodes_length; i++)
-            if (inodes[i].type == INodeType::UNUSED_NODE)
-                return i;
-        std::cerr << "Lack of empty inodes\n";
-        exit(EXIT_FAILURE);
-        return -1;
-    }
-
-    u_int32_t get_empty_data_block(){
-        for(u_int32_t i = 0; i < data_blocks_length; i++)
-            if (data_maps[i] == false)
-                return i;
-        std::cerr << "Lack of empty data blokcs\n";
-        exit(EXIT_FAILURE);
-        return -1;
-    }
-
-    INode* get_inode_in_inode(INode *direcotry, std::string name){
-        if(name == "")
-            return direcotry;
-        DirectoryLink *directory_link = get_direcotry_in_inode(direcotry, name);
-        if(!directory_link)
-            return NULL;
-        return &inodes[directory_link->inode_id];
-    }
-
-    DirectoryLink *get_direcotry_in_inode(INode *direcotry, std::string name){
-        if(direcotry->type != INodeType::DIRECTORY_NODE)
-            return NULL;
-        u_int64_t current_data_block_idx = direcotry->data_block_index;
-        while(current_data_block_idx != (u_int64_t)-1){
-            DirectoryLink* direcotry_links = (DirectoryLink*)data_blocks[current_data_block_idx].data;
-            for(u_int64_t idx = 0; idx < DIRECTORY_LINKS_IN_DATA_BLOCK; idx++){
-                DirectoryLink directory_link = direcotry_links[idx];
-                if((directory_link.used) && strcmp((char*)directory_link.name, name.c_str()) == 0)
-                    return &direcotry_links[idx];
-            }
-            current_data_block_idx = data_blocks[current_data_block_idx].offset;
-        }
-        return NULL;
-    }
-
-    void load_lengths(SuperBlock super_block_){
-        inodes_length = super_block_.inodes_count;
-        data_maps_length = super_block_.unused_datablocks;
-        data_blocks_length = super_block_.unused_datablocks;
-    }
-
-    void add_link_to_inode(INode* inode, DirectoryLink directory_link){
-        if(inode->data_block_index == (u_int64_t)-1){
-            inode->data_block_index = get_empty_data_block();
-            data_maps[inode->data_block_index] = true;
-        }
-        u_int64_t current_data_block_idx = inode->data_block_index;
-        bool is_place_for_link = false;
-        while(!is_place_for_link){
-            DirectoryLink* direcotry_links = (DirectoryLink*)data_blocks[current_data_block_idx].data;
-            for(u_int64_t idx = 0; idx < DIRECTORY_LINKS_IN_DATA_BLOCK; idx++){
-                if(!direcotry_links[idx].used){
-                    direcotry_links[idx] = directory_link;
-                    is_place_for_link = true;
-                    break;
-                }
-            }
-            if(is_place_for_link)
-                break;
-            if(data_blocks[current_data_block_idx].offset){
-                current_data_block_idx = data_blocks[current_data_block_idx].offset;
-            } else{
-                u_int64_t new_data_block_idx = get_empty_data_block();
-                data_blocks[current_data_block_idx].offset = new_data_block_idx;
-                data_maps[current_data_block_idx] = true;
-            }
-        }
-    }
-
-    void remove_data_block_from_inode(INode* inode, u_int64_t data_block_idx){
-        u_int64_t current_data_block_idx = inode->data_block_index;
-        while(current_data_block_idx != (u_int64_t)-1){
-            if(current_data_block_idx == data_block_idx){
-                data_blocks[current_data_block_idx].offset = -1;
-                return;
-            }
-            current_data_block_idx = data_blocks[current_data_block_idx].offset;
-        }
-    }
-
-    INode *get_direcotry_inode(std::vector<std::string> directories){
-        INode *current_direcotry_inode = inodes;
-        for(auto current_directory_name : directories){
-            if(!is_valid_name(current_directory_name)){
-                std::cerr << "Invalid directory name: " << current_directory_name << "\n";
-                exit(EXIT_FAILURE);
-            }
-            INode* next_direcotry_inode = get_inode_in_inode(current_direcotry_inode, current_directory_name);
-            if(next_direcotry_inode && next_direcotry_inode->type == INodeType::DIRECTORY_NODE){
-                current_direcotry_inode = next_direcotry_inode;
-            } else{
-                std::cerr << "Missing directory: " << next_direcotry_inode << "\n";
-                return NULL;
-            }
-        }
-        return current_direcotry_inode;
-    }
-
-    u_int64_t get_size_inode(INode *direcotry){
-        u_int64_t size = 0;
-        u_int64_t current_data_block_idx = direcotry->data_block_index;
-        while(current_data_block_idx != (u_int64_t)-1){
-            DirectoryLink* direcotry_links = (DirectoryLink*)data_blocks[current_data_block_idx].data;
-            for(u_int64_t idx = 0; idx < DIRECTORY_LINKS_IN_DATA_BLOCK; idx++){
-                if(direcotry_links[idx].used){
-                    if(std::find(shown_inodes.begin(),shown_inodes.end(), &inodes[direcotry_links[idx].inode_id]) != shown_inodes.end())
-                        continue;
-                    shown_inodes.push_back(&inodes[direcotry_links[idx].inode_id]);
-                    if(inodes[direcotry_links[idx].inode_id].type == INodeType::FILE_NODE)
-                        size += inodes[direcotry_links[idx].inode_id].size;
-                    else
-                        size += get_size_inode(&inodes[direcotry_links[idx].inode_id]);
-                }
-            }
-            current_data_block_idx = data_blocks[current_data_block_idx].offset;
-        }
-        return size;
-    }
-
-    void show_files_inode(INode* directory_inode, int rec_lvl){
-        if(directory_inode->type != INodeType::DIRECTORY_NODE)
-            return;
-        u_int64_t current_data_block_idx = directory_inode->data_block_index;
-        while(current_data_block_idx != (u_int64_t)-1){
-            std::cout << "\n";
-            for(int i = 0; i < rec_lvl; i++)
-                std::cout << "  ";
-            DirectoryLink* direcotry_links = (DirectoryLink*)data_blocks[current_data_block_idx].data;
-            for(u_int64_t idx = 0; idx < DIRECTORY_LINKS_IN_DATA_BLOCK; idx++){
-                if(!direcotry_links[idx].used)
-                    continue;
-                if(std::find(shown_direcotry_links.begin(),shown_direcotry_links.end(), &direcotry_links[idx]) != shown_direcotry_links.end())
-                    continue;
-                shown_direcotry_links.push_back(&direcotry_links[idx]);
-                if (inodes[direcotry_links[idx].inode_id].type == INodeType::DIRECTORY_NODE)
-                    std:: cout << "\x1B[34m" << direcotry_links[idx].name << "\033[0m ";
-                else
-                    std::cout << direcotry_links[idx].name << " ";
-                show_files_inode(&inodes[direcotry_links[idx].inode_id], rec_lvl + 1);
-            }
-            std::cout << "\n";
-            for(int i = 0; i < rec_lvl - 1; i++)
-                std::cout << "  ";
-            current_data_block_idx = data_blocks[current_data_block_idx].offset;
-        }
-    }
-
-    void remove_inode(INode* inode){
-        inode->reference_count -= 1;
-        if(inode->reference_count != 0)
-            return;
-        if(inode->type == INodeType::DIRECTORY_NODE){
-            u_int64_t current_data_block_idx = inode->data_block_index;
-            while(current_data_block_idx != (u_int64_t)-1){
-                DirectoryLink* direcotry_links = (DirectoryLink*)data_blocks[current_data_block_idx].data;
-                for(u_int64_t idx = 0; idx < DIRECTORY_LINKS_IN_DATA_BLOCK; idx++){
-                    if(direcotry_links[idx].used){
-                        remove_inode(&inodes[direcotry_links[idx].inode_id]);
-                    }
-                }
-                current_data_block_idx = data_blocks[current_data_block_idx].offset;
-            }
-        }
-        clear_datablocks(inode->data_block_index);
-        inode->data_block_index = -1;
-        inode->type = INodeType::UNUSED_NODE;
-        inode->type = 0;
-        inode->reference_count = 0;
-    }
-
-    void clear_datablocks(u_int64_t data_block_idx){
-        std::vector<u_int64_t> data_blocks_idxs;
-        u_int64_t idx = data_block_idx;
-        while(idx != (u_int64_t)-1){
-            data_blocks_idxs.push_back(idx);
-            idx = data_blocks[idx].offset;
-        }
-        for(auto idx:data_blocks_idxs){
-            data_blocks[idx].offset = -1;
-            data_maps[idx] = false;
-        }
-    }
-
-    std::vector<std::string> split_pwd(std::string pwd){
-        std::vector<std::string> files;
-        if(pwd == "/"){
-            files.push_back("");
-            return files;
-        }
-        size_t counter = 0;
-        while((counter = pwd.find("/")) != std::string::npos){
-            files.push_back(pwd.substr(0, counter));
-            pwd.erase(0, counter + 1);
-        }
-        files.push_back(pwd);
-        return files;
-    }
-};
+#include "virtual_disc.h"
 
 #pragma region user_interface
 VirtualDisc virtual_disc;
@@ -689,18 +6,37 @@ VirtualDisc virtual_disc;
 void help(int argc, char* argv[]){
     std::cout << "Usage: "<< argv[0] << " \x1B[33mvirtual_disc_name \x1B[34mfunction\033[0m [function arguments]\n";
     std::cout << "-- \x1B[34mhelp\033[0m (show functions usage)\n";
-    std::cout << "-- \x1B[34mcreate \x1B[33msize\033[0m (create virtual disc)\n";
+    std::cout << "-- \x1B[34mcreate \x1B[33msize \x1B[32m[block_size [name_length [files_space]]]\033[0m (create virtual disc, default 8192 16 8)\n";
+    std::cout << "-- \x1B[34mconvert\033[0m (convert version 1 disc to current format)\n";
     std::cout << "-- \x1B[34mmkdir \x1B[33mpath_to_dictionary\033[0m (create dictionary)\n";
     std::cout << "-- \x1B[34mrm \x1B[33mpath_to_dictionary/file\033[0m (remove file or dictionary)\n";
     std::cout << "-- \x1B[34msend \x1B[33mpath_to_dictionary \x1B[32mfile_name\033[0m (send file to disc)\n";
+    std::cout << "-- \x1B[34msend -r \x1B[33mpath_to_dictionary \x1B[32mdirectory_name\033[0m (send directory tree to disc)\n";
     std::cout << "-- \x1B[34mget \x1B[33mpath_to_file \x1B[32mfile_name\033[0m (get file from disc)\n";
+    std::cout << "-- \x1B[34mget -r \x1B[33mpath_to_dictionary \x1B[32mdirectory_name\033[0m (get directory tree from disc)\n";
     std::cout << "-- \x1B[34mln \x1B[33mpath_to_dictionary/file \x1B[32mtarget_path_to_dictionary/file\033[0m (create hard link)\n";
+    std::cout << "-- \x1B[34mclone \x1B[33mpath_to_dictionary/file \x1B[32mtarget_path_to_dictionary/file\033[0m (create file sharing data blocks, copied on write)\n";
     std::cout << "-- \x1B[34mls \x1B[33mpath_to_dictionary\033[0m (show information about dictionary)\n";
     std::cout << "-- \x1B[34mcut \x1B[33mpath_to_file \x1B[32mbytes_amout\033[0m (truncate file's size)\n";
     std::cout << "-- \x1B[34mextend \x1B[33mpath_to_file \x1B[32mbytes_amout\033[0m (extend file's size)\n";
+    std::cout << "-- \x1B[34mread \x1B[33mpath_to_file \x1B[32moffset bytes_amout\033[0m (write file's bytes to standard output)\n";
+    std::cout << "-- \x1B[34mwrite \x1B[33mpath_to_file \x1B[32moffset\033[0m (write standard input into file at offset)\n";
     std::cout << "-- \x1B[34mtree \x1B[33mpath_to_dictionary\033[0m (show dictionary tree)\n";
+    std::cout << "-- \x1B[34msnapshot \x1B[33mname\033[0m (freeze current files tree, data blocks are copied on write)\n";
+    std::cout << "-- \x1B[34msnapshot -d \x1B[33mname\033[0m (remove snapshot)\n";
+    std::cout << "-- \x1B[34mrollback \x1B[33mname\033[0m (restore files tree of snapshot)\n";
+    std::cout << "-- \x1B[34mstats\033[0m (show operations statistics of this run)\n";
+    std::cout << "-- \x1B[34mbatch \x1B[33m[script_file]\033[0m (run one function per line from script or standard input, \x1B[34msync\033[0m flushes the disc)\n";
+    std::cout << "Environment: \x1B[33mVIRTUAL_DISC_MODE\033[0m=mmap|stream|cache|lazy (map image, copy it into memory, keep metadata in memory and cache data blocks or load data blocks on first access, default mmap)\n";
+    std::cout << "Environment: \x1B[33mVIRTUAL_DISC_CACHE_SIZE\033[0m=megabytes (data blocks cache size of cache mode, default 64)\n";
+    std::cout << "Environment: \x1B[33mVIRTUAL_DISC_STATS\033[0m=1 (show operations statistics on standard error at exit)\n";
+    std::cout << "Environment: \x1B[33mVIRTUAL_DISC_THREADS\033[0m=count (workers copying files of recursive functions, default cores count)\n";
+    std::cout << "Environment: \x1B[33mVIRTUAL_DISC_IO\033[0m=sync|threads|uring (stream mode transfers of open, close, send and get, default sync)\n";
+    std::cout << "Environment: \x1B[33mVIRTUAL_DISC_QUEUE_DEPTH\033[0m=count (transfers in flight of threads and uring, default 32)\n";
+    std::cout << "Environment: \x1B[33mVIRTUAL_DISC_GROUP_COMMIT\033[0m=count (commit journal every count batch functions, default only at sync and exit)\n";
+    std::cout << "Environment: \x1B[33mVIRTUAL_DISC_DIRECT\033[0m=1 (bypass page cache for data blocks when block size is a multiple of 4096)\n";
 }
-void mkdir(int argc, char* argv[]){
+void make_directory(int argc, char* argv[]){
     if (argc != 4)
         help(argc, argv);
     else
@@ -718,20 +54,30 @@ void remove_file(int argc, char* argv[]){
     else
         virtual_disc.remove_link(argv[3]);
 }
-void link(int argc, char* argv[]){
+void hard_link(int argc, char* argv[]){
     if (argc != 5)
         help(argc, argv);
     else
         virtual_disc.create_link(argv[3], argv[4]);
 }
-void send_file(int argc, char* argv[]){
+void clone_file(int argc, char* argv[]){
     if (argc != 5)
         help(argc, argv);
+    else
+        virtual_disc.clone_file(argv[3], argv[4]);
+}
+void send_file(int argc, char* argv[]){
+    if (argc == 6 && std::string(argv[3]) == "-r")
+        virtual_disc.directory_to_disc(argv[4], argv[5]);
+    else if (argc != 5)
+        help(argc, argv);
     else
         virtual_disc.file_to_disc(argv[3], argv[4]);
 }
 void get_file(int argc, char* argv[]){
-    if (argc != 5)
+    if (argc == 6 && std::string(argv[3]) == "-r")
+        virtual_disc.directory_from_disc(argv[4], argv[5]);
+    else if (argc != 5)
         help(argc, argv);
     else
         virtual_disc.file_from_disc(argv[3], argv[4]);
@@ -754,11 +100,131 @@ void extend_file(int argc, char* argv[]){
     else
         virtual_disc.extend_file(argv[3], atoi(argv[4]));
 }
-void create(int argc, char* argv[]){
+void read_file(int argc, char* argv[]){
+    if (argc != 6)
+        help(argc, argv);
+    else{
+        std::vector<u_int8_t> buffer(1 << 20);
+        u_int64_t offset = std::stoull(argv[4]);
+        u_int64_t left_size = std::stoull(argv[5]);
+        while(left_size > 0){
+            u_int64_t read = virtual_disc.read_file(argv[3], offset, buffer.data(), std::min<u_int64_t>(left_size, buffer.size()));
+            if(!read)
+                break;
+            std::cout.write((char*)buffer.data(), read);
+            virtual_disc.release_blocks();
+            offset += read;
+            left_size -= read;
+        }
+    }
+}
+void write_file(int argc, char* argv[]){
+    if (argc != 5)
+        help(argc, argv);
+    else{
+        std::vector<u_int8_t> buffer(1 << 20);
+        u_int64_t offset = std::stoull(argv[4]);
+        while(std::cin.read((char*)buffer.data(), buffer.size()) || std::cin.gcount()){
+            virtual_disc.write_file(argv[3], offset, buffer.data(), std::cin.gcount());
+            virtual_disc.release_blocks();
+            offset += std::cin.gcount();
+        }
+    }
+}
+void snapshot(int argc, char* argv[]){
+    if (argc == 5 && std::string(argv[3]) == "-d")
+        virtual_disc.remove_snapshot(argv[4]);
+    else if (argc != 4)
+        help(argc, argv);
+    else
+        virtual_disc.create_snapshot(argv[3]);
+}
+void rollback(int argc, char* argv[]){
     if (argc != 4)
         help(argc, argv);
     else
-        virtual_disc.create(argv[1], std::stoul(argv[3]));
+        virtual_disc.rollback_snapshot(argv[3]);
+}
+void convert(int argc, char* argv[]){
+    if (argc != 3)
+        help(argc, argv);
+    else
+        virtual_disc.convert_from_v1(argv[1]);
+}
+void statistics(int argc, char* argv[]){
+    if (argc != 3)
+        help(argc, argv);
+    else
+        virtual_disc.show_statistics(std::cout);
+}
+void dump_statistics(){
+    virtual_disc.show_statistics(std::cerr);
+}
+void create(int argc, char* argv[]){
+    if (argc < 4 || argc > 7)
+        help(argc, argv);
+    else
+        virtual_disc.create(argv[1], std::stoul(argv[3]),
+            argc > 4 ? std::stoul(argv[4]) : DATA_BLOCK_SIZE,
+            argc > 5 ? std::stoul(argv[5]) : NAME_LENGTH,
+            argc > 6 ? std::stoul(argv[6]) : FILES_SPACE);
+}
+std::unordered_map<std::string, std::function<void(int, char**)>> functions {
+    {"help", help}, {"mkdir", make_directory}, {"tree", tree}, {"rm", remove_file},
+    {"ln", hard_link}, {"clone", clone_file}, {"send", send_file}, {"get", get_file}, {"ls", information},
+    {"cut", cut_file}, {"extend", extend_file}, {"read", read_file}, {"write", write_file},
+    {"snapshot", snapshot}, {"rollback", rollback}, {"stats", statistics}, {"create", create}, {"convert", convert}
+};
+void run_function(const std::string &name, std::function<void(int, char**)> &function, int argc, char* argv[]){
+    auto start = std::chrono::steady_clock::now();
+    function(argc, argv);
+    virtual_disc.release_blocks();
+    virtual_disc.record_operation(name, VirtualDisc::get_nanoseconds_since(start));
+}
+
+void batch(int argc, char* argv[]){
+    if (argc != 3 && argc != 4){
+        help(argc, argv);
+        return;
+    }
+    std::ifstream script_file;
+    std::istream *script = &std::cin;
+    if(argc == 4 && std::string(argv[3]) != "-"){
+        script_file.open(argv[3]);
+        if(!script_file){
+            std::cout << "Cannot open file";
+            exit(EXIT_FAILURE);
+        }
+        script = &script_file;
+    }
+    const char* group_commit = getenv("VIRTUAL_DISC_GROUP_COMMIT");
+    u_int64_t group_size = group_commit ? atoll(group_commit) : 0;
+    u_int64_t functions_count = 0;
+    std::string line;
+    while(std::getline(*script, line)){
+        std::istringstream line_stream(line);
+        std::vector<std::string> words{argv[0], argv[1]};
+        std::string word;
+        while(line_stream >> word)
+            words.push_back(word);
+        if(words.size() == 2 || words[2][0] == '#')
+            continue;
+        if(words[2] == "sync"){
+            virtual_disc.sync();
+            continue;
+        }
+        auto function = functions.find(words[2]);
+        if(function == functions.end() || words[2] == "create" || words[2] == "convert" || words[2] == "batch"){
+            std::cerr << "Invalid batch function: " << words[2] << "\n";
+            exit(EXIT_FAILURE);
+        }
+        std::vector<char*> arguments;
+        for(auto &argument : words)
+            arguments.push_back(argument.data());
+        run_function(words[2], function->second, arguments.size(), arguments.data());
+        if(group_size && ++functions_count % group_size == 0)
+            virtual_disc.sync();
+    }
 }
 #pragma endregion
 
@@ -768,22 +234,39 @@ int main(int argc, char* argv[]) {
         help(argc, argv);
         return -1;
     }
-    std::unordered_map<std::string, std::function<void(int, char**)>> functions {
-        {"help", help}, {"mkdir", mkdir}, {"tree", tree}, {"rm", remove_file},
-        {"ln", link}, {"send", send_file}, {"get", get_file}, {"ls", information},
-        {"cut", cut_file}, {"extend", extend_file}, {"create", create}
-    };
+    functions["batch"] = batch;
     virtual_disc.set_name(argv[1]);
+    const char* open_mode = getenv("VIRTUAL_DISC_MODE");
+    if(open_mode && std::string(open_mode) == "stream")
+        virtual_disc.set_open_mode(OpenMode::STREAM_MODE);
+    else if(open_mode && std::string(open_mode) == "cache")
+        virtual_disc.set_open_mode(OpenMode::CACHE_MODE);
+    else if(open_mode && std::string(open_mode) == "lazy")
+        virtual_disc.set_open_mode(OpenMode::LAZY_MODE);
+    const char* cache_size = getenv("VIRTUAL_DISC_CACHE_SIZE");
+    if(cache_size)
+        virtual_disc.set_cache_size(atoll(cache_size) << 20);
+    const char* workers_count = getenv("VIRTUAL_DISC_THREADS");
+    virtual_disc.set_workers_count(workers_count ? atoll(workers_count) : std::thread::hardware_concurrency());
+    const char* io_backend = getenv("VIRTUAL_DISC_IO");
+    const char* queue_depth = getenv("VIRTUAL_DISC_QUEUE_DEPTH");
+    IOBackend backend = IOBackend::SYNC_IO;
+    if(io_backend && std::string(io_backend) == "threads")
+        backend = IOBackend::THREADS_IO;
+    else if(io_backend && std::string(io_backend) == "uring")
+        backend = IOBackend::URING_IO;
+    virtual_disc.set_io_backend(backend, queue_depth ? atoll(queue_depth) : QUEUE_DEPTH, getenv("VIRTUAL_DISC_DIRECT") != NULL);
     std::string function = std::string(argv[2]);
-    for (auto f : functions){
-        if(function == f.first){
-            if(f.first != "create"){
-                virtual_disc.open();
-                f.second(argc, argv);
-                virtual_disc.close();
-            } else
-                f.second(argc, argv);
-        }
-    }
+    auto f = functions.find(function);
+    if(f == functions.end())
+        return 0;
+    if(getenv("VIRTUAL_DISC_STATS"))
+        atexit(dump_statistics);
+    if(f->first != "create" && f->first != "convert"){
+        virtual_disc.open();
+        run_function(f->first, f->second, argc, argv);
+        virtual_disc.close();
+    } else
+        run_function(f->first, f->second, argc, argv);
     return 0;
-}
\ No newline at end of file
+}
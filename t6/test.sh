@@ -90,5 +90,122 @@ case $number_of_test in
     ./a.out $disc_name ls /
     ./a.out $disc_name tree /
     ;;
+    "11")
+    echo "Reading and writing file fragments\n"
+    ./a.out $disc_name send / matejko
+    ./a.out $disc_name read matejko 100 50 > fragment_out
+    dd if=matejko of=fragment bs=1 skip=100 count=50 status=none
+    diff fragment fragment_out
+    printf "fragment" | ./a.out $disc_name write matejko 9000
+    ./a.out $disc_name read matejko 9000 8
+    ./a.out $disc_name ls /
+    ./a.out $disc_name rm matejko
+    ;;
+    "12")
+    echo "Running batch of functions on one open disc\n"
+    printf "mkdir c/d\nsend c/d matejko\nsync\nls c/d\ntree /\nrm c\n" | ./a.out $disc_name batch
+    ./a.out $disc_name tree /
+    ;;
+    "13")
+    echo "Coping directory tree from disc to virtual disc\n"
+    mkdir -p tree_in/a/b
+    cp matejko tree_in/a
+    cp tadek tree_in/a/b
+    ./a.out $disc_name send -r c tree_in
+    ./a.out $disc_name tree /
+    ./a.out $disc_name get c/a/b/tadek tadek_out
+    diff tadek tadek_out
+    ./a.out $disc_name rm c
+    ;;
+    "14")
+    echo "Coping directory tree from virtual disc to disc\n"
+    ./a.out $disc_name send -r c tree_in
+    ./a.out $disc_name get -r c tree_out
+    diff -r tree_in tree_out
+    ./a.out $disc_name rm c
+    ;;
+    "15")
+    echo "Showing operations statistics\n"
+    printf "mkdir s\nsend s matejko\nget s/matejko matejko_out\nstats\nrm s\n" | ./a.out $disc_name batch
+    VIRTUAL_DISC_STATS=1 ./a.out $disc_name ls /
+    ;;
+    "16")
+    echo "Creating disc with 4096 blocks and 32 name length\n"
+    ./a.out geometry create 2097152 4096 32
+    ./a.out geometry mkdir directory_with_long_name
+    ./a.out geometry send directory_with_long_name tadek
+    ./a.out geometry get directory_with_long_name/tadek tadek_out
+    diff tadek tadek_out
+    ./a.out geometry ls directory_with_long_name
+    rm geometry
+    ;;
+    "17")
+    echo "Storing small file inside inode\n"
+    printf "key=value\n" > small
+    ./a.out $disc_name send / small
+    ./a.out $disc_name ls /
+    ./a.out $disc_name get small small_out
+    diff small small_out
+    printf "moved to data block" | ./a.out $disc_name write small 200
+    ./a.out $disc_name read small 0 10
+    ./a.out $disc_name read small 200 19
+    ./a.out $disc_name ls /
+    ./a.out $disc_name rm small
+    ;;
+    "18")
+    echo "Committing batch through journal in groups\n"
+    printf "mkdir j\nsend j tadek\nmkdir j/k\nsend j/k matejko\nrm j/tadek\n" | VIRTUAL_DISC_MODE=stream VIRTUAL_DISC_GROUP_COMMIT=2 ./a.out $disc_name batch
+    test ! -e $disc_name.journal
+    ./a.out $disc_name get j/k/matejko matejko_out
+    diff matejko matejko_out
+    ./a.out $disc_name ls j
+    ./a.out $disc_name rm j
+    ;;
+    "19")
+    echo "Rolling back to snapshot after changes\n"
+    ./a.out $disc_name mkdir p
+    ./a.out $disc_name send p tadek
+    ./a.out $disc_name snapshot before
+    printf "changed" | ./a.out $disc_name write p/tadek 0
+    ./a.out $disc_name send p matejko
+    ./a.out $disc_name ls p
+    ./a.out $disc_name rollback before
+    ./a.out $disc_name get p/tadek tadek_out
+    diff tadek tadek_out
+    ./a.out $disc_name ls p
+    ./a.out $disc_name snapshot -d before
+    ./a.out $disc_name rm p
+    ;;
+    "20")
+    echo "Cloning file and writing to the clone\n"
+    ./a.out $disc_name send / tadek
+    ./a.out $disc_name clone tadek tadek_clone
+    ./a.out $disc_name ls /
+    printf "changed" | ./a.out $disc_name write tadek_clone 0
+    ./a.out $disc_name read tadek_clone 0 7
+    ./a.out $disc_name get tadek tadek_out
+    ./a.out $disc_name get tadek_clone tadek_clone_out
+    cmp tadek tadek_out
+    { printf "changed"; tail -c +8 tadek; } > tadek_clone_expected
+    cmp tadek_clone_expected tadek_clone_out
+    ./a.out $disc_name rm tadek
+    ./a.out $disc_name read tadek_clone 0 7
+    ./a.out $disc_name rm tadek_clone
+    ;;
+    "21")
+    echo "Converting version 1 disc with a hard link\n"
+    cp v1_disc v1_converted
+    ./a.out v1_converted convert
+    ./a.out v1_converted tree /
+    ./a.out v1_converted ls /
+    seq 1 5000 > numbers
+    ./a.out v1_converted get docs/numbers numbers_out
+    cmp numbers numbers_out
+    ./a.out v1_converted get numbers_link numbers_out
+    cmp numbers numbers_out
+    printf "changed" | ./a.out v1_converted write numbers_link 0
+    ./a.out v1_converted read docs/numbers 0 7
+    rm v1_converted
+    ;;
     *) echo "No test" ;;
 esac
\ No newline at end of file
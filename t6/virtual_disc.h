@@ -0,0 +1,3128 @@
+#ifndef __virtual_disc_h
+#define __virtual_disc_h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <string.h>
+#include <string>
+#include <string_view>
+#include <deque>
+#include <list>
+#include <sstream>
+#include <unordered_map>
+#include <functional>
+#include <fstream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/sendfile.h>
+#include <errno.h>
+#include <set>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <filesystem>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <stddef.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+
+#define DATA_BLOCK_SIZE 8192
+#define MIN_DATA_BLOCK_SIZE 512
+#define MAX_DATA_BLOCK_SIZE (16 << 20)
+#define NAME_LENGTH 16
+#define MAX_NAME_LENGTH 255
+#define FILES_SPACE 8
+#define INODE_EXTENTS 4
+#define INODE_INLINE_SIZE (sizeof(ExtentHeader) + INODE_EXTENTS * sizeof(Extent))
+#define INODE_INLINE 1
+#define INODE_SHARED 2
+#define LINK_SIZE_OF(link_type, name_length) ((offsetof(link_type, name) + (name_length) + alignof(link_type) - 1) & ~(u_int64_t)(alignof(link_type) - 1))
+#define LINK_SIZE(name_length) LINK_SIZE_OF(DirectoryLink, name_length)
+#define DISC_MAGIC 0x5649525455414C44ull
+#define DISC_VERSION 2
+#define MAP_WORD_BITS 64
+#define MAP_WORDS(bits) (((bits) + MAP_WORD_BITS - 1) / MAP_WORD_BITS)
+#define DATA_ALIGNMENT 4096
+#define ALIGN_UP(offset, alignment) (((offset) + (alignment) - 1) & ~(u_int64_t)((alignment) - 1))
+#define LATENCY_BUCKETS 40
+#define PATH_CACHE_SIZE 4096
+#define QUEUE_DEPTH 32
+#define TRANSFER_CHUNK_SIZE (1 << 20)
+#define CACHE_SIZE (64 << 20)
+#define JOURNAL_MAGIC 0x4C4E524A4B534944ull
+
+#pragma region structures
+
+enum OpenMode{
+    STREAM_MODE,
+    MMAP_MODE,
+    CACHE_MODE,
+    LAZY_MODE
+};
+
+enum IOBackend{
+    SYNC_IO,
+    THREADS_IO,
+    URING_IO
+};
+
+enum INodeType{
+    UNUSED_NODE,
+    FILE_NODE,
+    DIRECTORY_NODE
+};
+
+struct Extent{
+    u_int64_t file_block;
+    u_int64_t data_block_index;
+    u_int64_t length;
+};
+
+struct ExtentHeader{
+    u_int32_t depth;
+    u_int32_t count;
+};
+
+struct INode{
+    u_int64_t size;
+    u_int64_t blocks_count;
+    ExtentHeader extent_header;
+    Extent extents[INODE_EXTENTS];
+
+    u_int8_t type;
+    u_int8_t flags;
+    u_int32_t reference_count;
+};
+
+struct DirectoryLink{
+    u_int32_t inode_id;
+
+    u_int8_t used;
+    u_int8_t name[MAX_NAME_LENGTH];
+};
+
+struct SuperBlock{
+    u_int64_t magic;
+    u_int64_t disc_size;
+    u_int64_t inode_offset;
+    u_int64_t inode_map_offset;
+    u_int64_t data_map_offset;
+    u_int64_t data_block_offset;
+
+    u_int32_t unused_inodes;
+    u_int32_t inodes_count;
+    u_int32_t unused_datablocks;
+    u_int32_t datablocks_count;
+    u_int32_t inode_map_cursor;
+    u_int32_t data_map_cursor;
+    u_int32_t block_size;
+    u_int32_t name_length;
+    u_int32_t files_space;
+    u_int32_t version;
+
+    u_int8_t name[NAME_LENGTH];
+};
+
+struct JournalHeader{
+    u_int64_t magic;
+    u_int64_t entries_count;
+    u_int64_t payload_size;
+    u_int64_t checksum;
+};
+
+struct JournalEntry{
+    u_int64_t offset;
+    u_int64_t size;
+};
+
+struct INodeV1{
+    u_int64_t size;
+    u_int64_t data_block_index;
+
+    u_int8_t type;
+    u_int8_t reference_count;
+};
+
+struct DataBlockV1{
+    u_int64_t offset;
+
+    u_int8_t data[DATA_BLOCK_SIZE];
+};
+
+struct DirectoryLinkV1{
+    u_int16_t inode_id;
+
+    u_int8_t used;
+    u_int8_t name[NAME_LENGTH];
+};
+
+struct SuperBlockV1{
+    u_int64_t disc_size;
+    u_int64_t inode_offset;
+    u_int64_t data_map_offset;
+    u_int64_t data_block_offset;
+
+    u_int32_t unused_inodes;
+    u_int32_t inodes_count;
+    u_int32_t unused_datablocks;
+    u_int32_t datablocks_count;
+
+    u_int8_t name[NAME_LENGTH];
+};
+
+class PathTokenizer{
+private:
+    std::string_view path;
+    size_t position;
+
+public:
+    PathTokenizer(std::string_view path_, size_t position_ = 0) : path(path_), position(position_) {}
+
+    bool next(std::string_view &component){
+        if(position > path.size())
+            return false;
+        size_t end = path.find('/', position);
+        if(end == std::string_view::npos)
+            end = path.size();
+        component = path.substr(position, end - position);
+        position = end + 1;
+        return true;
+    }
+
+    size_t end(){
+        return position - 1;
+    }
+};
+
+struct DirectoryIndex{
+    std::unordered_multimap<size_t, u_int64_t> links;
+    std::vector<u_int64_t> free_links;
+};
+
+struct SharedExtent{
+    u_int64_t length;
+    u_int32_t references;
+};
+
+struct LatencyHistogram{
+    u_int64_t count = 0;
+    u_int64_t total_nanoseconds = 0;
+    u_int64_t buckets[LATENCY_BUCKETS] = {};
+
+    void add(u_int64_t nanoseconds){
+        u_int64_t microseconds = nanoseconds / 1000;
+        u_int64_t bucket = microseconds ? 64 - __builtin_clzll(microseconds) : 0;
+        buckets[std::min<u_int64_t>(bucket, LATENCY_BUCKETS - 1)] += 1;
+        count += 1;
+        total_nanoseconds += nanoseconds;
+    }
+};
+
+struct DiscStatistics{
+    std::atomic<u_int64_t> inode_allocations{0};
+    std::atomic<u_int64_t> data_block_allocations{0};
+    std::atomic<u_int64_t> extent_hops{0};
+    std::atomic<u_int64_t> directory_entries_scanned{0};
+    std::atomic<u_int64_t> bytes_read{0};
+    std::atomic<u_int64_t> bytes_written{0};
+    std::atomic<u_int64_t> cache_hits{0};
+    std::atomic<u_int64_t> cache_misses{0};
+    std::atomic<u_int64_t> cache_evictions{0};
+    std::atomic<u_int64_t> lazy_loads{0};
+    std::atomic<u_int64_t> journal_commits{0};
+    std::atomic<u_int64_t> journal_bytes{0};
+    std::atomic<u_int64_t> open_nanoseconds{0};
+    std::atomic<u_int64_t> close_nanoseconds{0};
+    std::map<std::string, LatencyHistogram> operations;
+};
+
+struct FileCopyJob{
+    std::string file_name;
+    u_int64_t size;
+    std::vector<u_int64_t> data_blocks;
+    INode *inode;
+};
+
+struct FileExportJob{
+    std::string file_name;
+    INode *inode;
+};
+
+template<typename Job>
+class WorkerPool{
+    std::deque<Job> jobs;
+    std::mutex jobs_mutex;
+    std::condition_variable jobs_condition;
+    std::vector<std::thread> workers;
+    bool closed = false;
+public:
+    WorkerPool(u_int64_t workers_count, std::function<void(Job&)> work){
+        for(u_int64_t i = 0; i < std::max<u_int64_t>(workers_count, 1); i++)
+            workers.emplace_back([this, work](){
+                while(true){
+                    std::unique_lock<std::mutex> lock(jobs_mutex);
+                    jobs_condition.wait(lock, [this](){ return closed || !jobs.empty(); });
+                    if(jobs.empty())
+                        return;
+                    Job job = std::move(jobs.front());
+                    jobs.pop_front();
+                    lock.unlock();
+                    work(job);
+                }
+            });
+    }
+    ~WorkerPool(){
+        wait();
+    }
+    void push(Job job){
+        {
+            std::lock_guard<std::mutex> lock(jobs_mutex);
+            jobs.push_back(std::move(job));
+        }
+        jobs_condition.notify_one();
+    }
+    void wait(){
+        {
+            std::lock_guard<std::mutex> lock(jobs_mutex);
+            closed = true;
+        }
+        jobs_condition.notify_all();
+        for(auto &worker : workers)
+            worker.join();
+        workers.clear();
+    }
+};
+
+struct BlockRequest{
+    int descriptor;
+    u_int8_t *buffer;
+    u_int64_t size;
+    u_int64_t offset;
+    bool write;
+};
+
+class BlockTransfer{
+    IOBackend backend = IOBackend::SYNC_IO;
+    u_int64_t queue_depth = QUEUE_DEPTH;
+    std::mutex ring_mutex;
+    int ring_descriptor = -1;
+    u_int8_t *submission_ring = NULL;
+    u_int8_t *completion_ring = NULL;
+    io_uring_sqe *submission_entries = NULL;
+    u_int64_t submission_ring_size = 0;
+    u_int64_t completion_ring_size = 0;
+    u_int64_t submission_entries_size = 0;
+    io_uring_params ring_parameters;
+
+public:
+    ~BlockTransfer(){
+        close_ring();
+    }
+
+    static void transfer(BlockRequest request){
+        while(request.size > 0){
+            ssize_t size = request.write ? pwrite(request.descriptor, request.buffer, request.size, request.offset)
+                                         : pread(request.descriptor, request.buffer, request.size, request.offset);
+            if(size < 0 && errno == EINTR)
+                continue;
+            if(size <= 0)
+                transfer_error(request);
+            request.buffer += size;
+            request.size -= size;
+            request.offset += size;
+        }
+    }
+
+    void setup(IOBackend backend_, u_int64_t queue_depth_){
+        close_ring();
+        backend = backend_;
+        queue_depth = std::max<u_int64_t>(queue_depth_, 1);
+        if(backend == IOBackend::URING_IO && !open_ring())
+            backend = IOBackend::THREADS_IO;
+    }
+
+    IOBackend get_backend(){
+        return backend;
+    }
+
+    void run(const std::vector<BlockRequest> &requests){
+        if(backend == IOBackend::SYNC_IO){
+            for(auto request : requests)
+                transfer(request);
+            return;
+        }
+        std::vector<BlockRequest> chunks;
+        for(auto &request : requests)
+            for(u_int64_t done = 0; done < request.size; done += TRANSFER_CHUNK_SIZE)
+                chunks.push_back(BlockRequest{request.descriptor, request.buffer + done, std::min<u_int64_t>(TRANSFER_CHUNK_SIZE, request.size - done), request.offset + done, request.write});
+        if(chunks.size() <= 1){
+            for(auto &chunk : chunks)
+                transfer(chunk);
+        } else if(backend == IOBackend::URING_IO)
+            run_ring(chunks);
+        else{
+            WorkerPool<BlockRequest> workers(std::min<u_int64_t>(queue_depth, chunks.size()), [this](BlockRequest &chunk){ transfer(chunk); });
+            for(auto &chunk : chunks)
+                workers.push(chunk);
+        }
+    }
+
+private:
+    static void transfer_error(const BlockRequest &request){
+        if(request.write)
+            std::cout << "Writing to file error";
+        else
+            std::cerr << "Invalid file";
+        exit(EXIT_FAILURE);
+    }
+
+    bool open_ring(){
+        memset(&ring_parameters, 0, sizeof(io_uring_params));
+        ring_descriptor = syscall(__NR_io_uring_setup, queue_depth, &ring_parameters);
+        if(ring_descriptor < 0)
+            return false;
+        queue_depth = std::min<u_int64_t>(queue_depth, ring_parameters.sq_entries);
+        submission_ring_size = ring_parameters.sq_off.array + ring_parameters.sq_entries * sizeof(u_int32_t);
+        completion_ring_size = ring_parameters.cq_off.cqes + ring_parameters.cq_entries * sizeof(io_uring_cqe);
+        if(ring_parameters.features & IORING_FEAT_SINGLE_MMAP)
+            submission_ring_size = completion_ring_size = std::max(submission_ring_size, completion_ring_size);
+        submission_entries_size = ring_parameters.sq_entries * sizeof(io_uring_sqe);
+        void *address = mmap(NULL, submission_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_descriptor, IORING_OFF_SQ_RING);
+        submission_ring = address == MAP_FAILED ? NULL : (u_int8_t*)address;
+        if(submission_ring && (ring_parameters.features & IORING_FEAT_SINGLE_MMAP))
+            completion_ring = submission_ring;
+        else if(submission_ring){
+            address = mmap(NULL, completion_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_descriptor, IORING_OFF_CQ_RING);
+            completion_ring = address == MAP_FAILED ? NULL : (u_int8_t*)address;
+        }
+        address = mmap(NULL, submission_entries_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_descriptor, IORING_OFF_SQES);
+        submission_entries = address == MAP_FAILED ? NULL : (io_uring_sqe*)address;
+        if(!submission_ring || !completion_ring || !submission_entries){
+            close_ring();
+            return false;
+        }
+        return true;
+    }
+
+    void close_ring(){
+        if(submission_entries)
+            munmap(submission_entries, submission_entries_size);
+        if(completion_ring && completion_ring != submission_ring)
+            munmap(completion_ring, completion_ring_size);
+        if(submission_ring)
+            munmap(submission_ring, submission_ring_size);
+        if(ring_descriptor >= 0)
+            ::close(ring_descriptor);
+        submission_entries = NULL;
+        completion_ring = submission_ring = NULL;
+        ring_descriptor = -1;
+    }
+
+    void push_entry(const BlockRequest &chunk, u_int64_t chunk_idx){
+        u_int32_t *tail = (u_int32_t*)(submission_ring + ring_parameters.sq_off.tail);
+        u_int32_t mask = *(u_int32_t*)(submission_ring + ring_parameters.sq_off.ring_mask);
+        u_int32_t *array = (u_int32_t*)(submission_ring + ring_parameters.sq_off.array);
+        u_int32_t index = *tail & mask;
+        io_uring_sqe &entry = submission_entries[index];
+        memset(&entry, 0, sizeof(io_uring_sqe));
+        entry.opcode = chunk.write ? IORING_OP_WRITE : IORING_OP_READ;
+        entry.fd = chunk.descriptor;
+        entry.addr = (u_int64_t)chunk.buffer;
+        entry.len = chunk.size;
+        entry.off = chunk.offset;
+        entry.user_data = chunk_idx;
+        array[index] = index;
+        __atomic_store_n(tail, *tail + 1, __ATOMIC_RELEASE);
+    }
+
+    void run_ring(std::vector<BlockRequest> &chunks){
+        std::lock_guard<std::mutex> lock(ring_mutex);
+        u_int32_t *head = (u_int32_t*)(completion_ring + ring_parameters.cq_off.head);
+        u_int32_t *tail = (u_int32_t*)(completion_ring + ring_parameters.cq_off.tail);
+        u_int32_t mask = *(u_int32_t*)(completion_ring + ring_parameters.cq_off.ring_mask);
+        io_uring_cqe *completions = (io_uring_cqe*)(completion_ring + ring_parameters.cq_off.cqes);
+        std::deque<u_int64_t> waiting;
+        for(u_int64_t idx = 0; idx < chunks.size(); idx++)
+            waiting.push_back(idx);
+        u_int64_t in_flight = 0, to_submit = 0;
+        while(!waiting.empty() || in_flight){
+            while(!waiting.empty() && in_flight < queue_depth){
+                push_entry(chunks[waiting.front()], waiting.front());
+                waiting.pop_front();
+                in_flight++;
+                to_submit++;
+            }
+            int submitted = syscall(__NR_io_uring_enter, ring_descriptor, to_submit, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+            if(submitted < 0 && errno != EINTR && errno != EAGAIN)
+                transfer_error(chunks[0]);
+            if(submitted > 0)
+                to_submit -= submitted;
+            u_int32_t completion_head = *head;
+            for(; completion_head != __atomic_load_n(tail, __ATOMIC_ACQUIRE); completion_head++){
+                io_uring_cqe &completion = completions[completion_head & mask];
+                BlockRequest &chunk = chunks[completion.user_data];
+                in_flight--;
+                if(completion.res == -EINTR || completion.res == -EAGAIN){
+                    waiting.push_back(completion.user_data);
+                    continue;
+                }
+                if(completion.res <= 0)
+                    transfer_error(chunk);
+                chunk.buffer += completion.res;
+                chunk.size -= completion.res;
+                chunk.offset += completion.res;
+                if(chunk.size > 0)
+                    waiting.push_back(completion.user_data);
+            }
+            __atomic_store_n(head, completion_head, __ATOMIC_RELEASE);
+        }
+    }
+};
+
+struct CacheFrame{
+    u_int8_t *data;
+    u_int64_t data_block_idx;
+    bool used;
+    bool referenced;
+    bool pinned;
+    bool dirty;
+};
+
+class BlockCache{
+    std::mutex cache_mutex;
+    int descriptor = -1;
+    u_int64_t data_block_offset = 0;
+    u_int64_t block_size = 0;
+    u_int64_t capacity = 0;
+    u_int64_t allocated_frames = 0;
+    u_int64_t clock_hand = 0;
+    std::vector<CacheFrame> frames;
+    std::vector<u_int64_t> empty_frames;
+    std::vector<u_int64_t> pinned_frames;
+    std::unordered_map<u_int64_t, u_int64_t> block_frames;
+    std::map<u_int8_t*, u_int64_t> frame_addresses;
+    std::set<u_int64_t> pending_dirty;
+    const std::vector<u_int64_t> *committed_maps = NULL;
+    DiscStatistics *statistics = NULL;
+
+public:
+    ~BlockCache(){
+        close();
+    }
+
+    void open(int descriptor_, u_int64_t data_block_offset_, u_int64_t block_size_, u_int64_t capacity_, const std::vector<u_int64_t> *committed_maps_, DiscStatistics *statistics_){
+        close();
+        descriptor = descriptor_;
+        data_block_offset = data_block_offset_;
+        block_size = block_size_;
+        capacity = std::max<u_int64_t>(capacity_, 1);
+        committed_maps = committed_maps_;
+        statistics = statistics_;
+    }
+
+    void close(){
+        for(auto &frame : frames)
+            if(frame.data)
+                operator delete[](frame.data, std::align_val_t(DATA_ALIGNMENT));
+        frames.clear();
+        empty_frames.clear();
+        pinned_frames.clear();
+        block_frames.clear();
+        frame_addresses.clear();
+        pending_dirty.clear();
+        allocated_frames = 0;
+        clock_hand = 0;
+    }
+
+    u_int8_t *get(u_int64_t data_block_idx){
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        auto it = block_frames.find(data_block_idx);
+        if(it != block_frames.end()){
+            statistics->cache_hits++;
+            frames[it->second].referenced = true;
+            pin(it->second);
+            return frames[it->second].data;
+        }
+        statistics->cache_misses++;
+        u_int64_t frame_idx = take_frame();
+        CacheFrame &frame = frames[frame_idx];
+        BlockTransfer::transfer({descriptor, frame.data, block_size, get_offset(data_block_idx), false});
+        frame.data_block_idx = data_block_idx;
+        frame.used = true;
+        frame.referenced = true;
+        frame.dirty = pending_dirty.erase(data_block_idx);
+        block_frames[data_block_idx] = frame_idx;
+        pin(frame_idx);
+        return frame.data;
+    }
+
+    u_int64_t get_data_block_idx(const void *address){
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        auto it = frame_addresses.upper_bound((u_int8_t*)address);
+        return frames[std::prev(it)->second].data_block_idx;
+    }
+
+    void mark_dirty(u_int64_t data_block_idx){
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        auto it = block_frames.find(data_block_idx);
+        if(it != block_frames.end())
+            frames[it->second].dirty = true;
+        else
+            pending_dirty.insert(data_block_idx);
+    }
+
+    void discard(u_int64_t data_block_idx, u_int64_t count){
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        for(u_int64_t idx = data_block_idx; idx < data_block_idx + count; idx++){
+            pending_dirty.erase(idx);
+            auto it = block_frames.find(idx);
+            if(it == block_frames.end())
+                continue;
+            frames[it->second].used = false;
+            frames[it->second].dirty = false;
+            block_frames.erase(it);
+        }
+    }
+
+    u_int8_t *get_dirty(u_int64_t data_block_idx){
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        auto it = block_frames.find(data_block_idx);
+        return it != block_frames.end() && frames[it->second].dirty ? frames[it->second].data : NULL;
+    }
+
+    std::vector<BlockRequest> flush(){
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        std::vector<BlockRequest> requests;
+        for(auto &frame : frames)
+            if(frame.used && frame.dirty){
+                requests.push_back({descriptor, frame.data, block_size, get_offset(frame.data_block_idx), true});
+                frame.dirty = false;
+            }
+        pending_dirty.clear();
+        return requests;
+    }
+
+    bool is_over_capacity(){
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        return allocated_frames > capacity;
+    }
+
+    void unpin(u_int64_t data_block_idx){
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        auto it = block_frames.find(data_block_idx);
+        if(it != block_frames.end())
+            frames[it->second].pinned = false;
+    }
+
+    void release(){
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        for(auto frame_idx : pinned_frames)
+            frames[frame_idx].pinned = false;
+        pinned_frames.clear();
+        for(u_int64_t frame_idx = 0; allocated_frames > capacity && frame_idx < frames.size(); frame_idx++){
+            CacheFrame &frame = frames[frame_idx];
+            if(!frame.data || !is_evictable(frame))
+                continue;
+            evict(frame);
+            frame_addresses.erase(frame.data);
+            operator delete[](frame.data, std::align_val_t(DATA_ALIGNMENT));
+            frame.data = NULL;
+            empty_frames.push_back(frame_idx);
+            allocated_frames--;
+        }
+    }
+
+private:
+    u_int64_t get_offset(u_int64_t data_block_idx){
+        return data_block_offset + data_block_idx * block_size;
+    }
+
+    void pin(u_int64_t frame_idx){
+        if(frames[frame_idx].pinned)
+            return;
+        frames[frame_idx].pinned = true;
+        pinned_frames.push_back(frame_idx);
+    }
+
+    bool is_evictable(CacheFrame &frame){
+        if(!frame.dirty)
+            return true;
+        u_int64_t idx = frame.data_block_idx;
+        return !((*committed_maps)[idx / MAP_WORD_BITS] >> (idx % MAP_WORD_BITS) & 1);
+    }
+
+    void evict(CacheFrame &frame){
+        if(!frame.used)
+            return;
+        if(frame.dirty)
+            BlockTransfer::transfer({descriptor, frame.data, block_size, get_offset(frame.data_block_idx), true});
+        frame.dirty = false;
+        block_frames.erase(frame.data_block_idx);
+        frame.used = false;
+        statistics->cache_evictions++;
+    }
+
+    u_int64_t take_frame(){
+        for(u_int64_t step = 0; allocated_frames >= capacity && step < 2 * frames.size(); step++){
+            u_int64_t frame_idx = clock_hand;
+            CacheFrame &frame = frames[frame_idx];
+            clock_hand = (clock_hand + 1) % frames.size();
+            if(!frame.data || frame.pinned || !is_evictable(frame))
+                continue;
+            if(frame.used && frame.referenced){
+                frame.referenced = false;
+                continue;
+            }
+            evict(frame);
+            return frame_idx;
+        }
+        u_int64_t frame_idx = frames.size();
+        if(!empty_frames.empty()){
+            frame_idx = empty_frames.back();
+            empty_frames.pop_back();
+        } else
+            frames.push_back(CacheFrame{});
+        frames[frame_idx].data = new (std::align_val_t(DATA_ALIGNMENT)) u_int8_t[block_size];
+        frame_addresses[frames[frame_idx].data] = frame_idx;
+        allocated_frames++;
+        return frame_idx;
+    }
+};
+
+#pragma endregion
+
+
+class DiscV1Reader{
+private:
+    u_int8_t *mapping = NULL;
+    u_int64_t mapping_size = 0;
+
+public:
+    SuperBlockV1 *super_block;
+    INodeV1 *inodes;
+    DataBlockV1 *data_blocks;
+
+    ~DiscV1Reader(){
+        if(mapping)
+            munmap(mapping, mapping_size);
+    }
+
+    bool open(std::string file_name){
+        int descriptor = ::open(file_name.c_str(), O_RDONLY);
+        struct stat file_stat;
+        if(descriptor < 0 || fstat(descriptor, &file_stat) < 0 || (u_int64_t)file_stat.st_size < sizeof(SuperBlockV1))
+            return false;
+        mapping_size = file_stat.st_size;
+        void *address = mmap(NULL, mapping_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        ::close(descriptor);
+        if(address == MAP_FAILED)
+            return false;
+        mapping = (u_int8_t*)address;
+        super_block = (SuperBlockV1*)mapping;
+        if(super_block->inode_offset != sizeof(SuperBlockV1) || super_block->inodes_count == 0
+            || super_block->data_map_offset != super_block->inode_offset + super_block->inodes_count * sizeof(INodeV1)
+            || super_block->data_block_offset != super_block->data_map_offset + super_block->datablocks_count * sizeof(bool)
+            || super_block->data_block_offset + super_block->datablocks_count * sizeof(DataBlockV1) > mapping_size)
+            return false;
+        inodes = (INodeV1*)(mapping + super_block->inode_offset);
+        data_blocks = (DataBlockV1*)(mapping + super_block->data_block_offset);
+        return inodes[0].type == INodeType::DIRECTORY_NODE;
+    }
+
+    void for_each_data_block(INodeV1 *inode, std::function<bool(DataBlockV1*)> visit){
+        u_int64_t data_block_idx = inode->data_block_index;
+        for(u_int64_t step = 0; step < super_block->datablocks_count && data_block_idx < super_block->datablocks_count; step++){
+            if(!visit(&data_blocks[data_block_idx]))
+                return;
+            data_block_idx = data_blocks[data_block_idx].offset;
+        }
+    }
+
+    void for_each_link(INodeV1 *directory, std::function<void(DirectoryLinkV1*)> visit){
+        for_each_data_block(directory, [&](DataBlockV1 *data_block){
+            DirectoryLinkV1 *links = (DirectoryLinkV1*)data_block->data;
+            for(u_int64_t idx = 0; idx < DATA_BLOCK_SIZE / sizeof(DirectoryLinkV1); idx++)
+                if(links[idx].used && links[idx].inode_id < super_block->inodes_count)
+                    visit(&links[idx]);
+            return true;
+        });
+    }
+};
+
+class VirtualDisc{
+private:
+    std::string name;
+    FILE* file;
+    INode *inodes;
+    u_int64_t *inode_maps;
+    u_int64_t *data_maps;
+    u_int8_t *data_blocks;
+    SuperBlock super_block;
+    u_int64_t inodes_length;
+    u_int64_t inode_maps_length;
+    u_int64_t data_maps_length;
+    u_int64_t data_blocks_length;
+    u_int64_t block_size;
+    u_int64_t name_length;
+    u_int64_t link_size;
+    u_int64_t links_in_block;
+    u_int64_t extents_in_block;
+    std::vector<DirectoryLink*> shown_direcotry_links;
+    std::vector<INode*> shown_inodes;
+    OpenMode open_mode = OpenMode::MMAP_MODE;
+    u_int64_t workers_count = 1;
+    BlockTransfer block_transfer;
+    BlockCache block_cache;
+    u_int64_t cache_size = CACHE_SIZE;
+    std::vector<u_int64_t> loaded_maps;
+    std::vector<u_int64_t> committed_data_maps;
+    SuperBlock committed_super_block;
+    bool checkpoint_pending = false;
+    std::vector<u_int64_t> frozen_maps;
+    std::map<u_int64_t, SharedExtent> shared_references;
+    bool shared_references_loaded = false;
+    std::mutex load_mutex;
+    bool direct_io = false;
+    DiscStatistics statistics;
+    u_int8_t *mapping = NULL;
+    int image_descriptor = -1;
+    u_int64_t mapping_size = 0;
+    std::set<u_int64_t> dirty_inodes;
+    std::set<u_int64_t> dirty_inode_maps;
+    std::set<u_int64_t> dirty_data_maps;
+    std::set<u_int64_t> dirty_data_blocks;
+    std::unordered_map<u_int64_t, DirectoryIndex> directory_indexes;
+    std::list<std::pair<std::string, u_int64_t>> path_cache_entries;
+    std::unordered_map<std::string_view, std::list<std::pair<std::string, u_int64_t>>::iterator> path_cache;
+
+
+public:
+    void create(std::string file_name, u_int64_t disc_size, u_int64_t block_size_ = DATA_BLOCK_SIZE, u_int64_t name_length_ = NAME_LENGTH, u_int64_t files_space = FILES_SPACE){
+        if(block_size_ < MIN_DATA_BLOCK_SIZE || block_size_ > MAX_DATA_BLOCK_SIZE || (block_size_ & (block_size_ - 1))){
+            std::cerr << "Invalid block size";
+            exit(EXIT_FAILURE);
+        }
+        if(name_length_ < 2 || name_length_ > MAX_NAME_LENGTH){
+            std::cerr << "Invalid name length";
+            exit(EXIT_FAILURE);
+        }
+        if(files_space == 0){
+            std::cerr << "Invalid files space";
+            exit(EXIT_FAILURE);
+        }
+        name = file_name;
+        unlink(get_journal_name().c_str());
+        for_each_snapshot([](const std::filesystem::path &snapshot){
+            unlink(snapshot.c_str());
+        });
+        int descriptor = ::open(file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if(descriptor < 0){
+            std::cout << "Cannot open file";
+            exit(EXIT_FAILURE);
+        }
+
+        u_int64_t number_of_inodes = disc_size / sizeof(INode) / files_space;
+        u_int64_t inodes_size = number_of_inodes * sizeof(INode) + MAP_WORDS(number_of_inodes) * sizeof(u_int64_t);
+        if(ALIGN_UP(sizeof(SuperBlock) + inodes_size + sizeof(u_int64_t), DATA_ALIGNMENT) + block_size_ > disc_size){
+            std::cerr << "Disc size too small";
+            exit(EXIT_FAILURE);
+        }
+        u_int64_t max_number_of_data_blocks = (disc_size - sizeof(SuperBlock) - inodes_size) / block_size_;
+        u_int64_t inode_map_offset = sizeof(SuperBlock) + number_of_inodes * sizeof(INode);
+        u_int64_t data_map_offset = inode_map_offset + MAP_WORDS(number_of_inodes) * sizeof(u_int64_t);
+        u_int64_t data_block_offset = ALIGN_UP(data_map_offset + MAP_WORDS(max_number_of_data_blocks) * sizeof(u_int64_t), DATA_ALIGNMENT);
+        u_int64_t number_of_data_blocks = (disc_size - data_block_offset) / block_size_;
+
+        strncpy((char*)super_block.name, name.c_str(), NAME_LENGTH);
+        super_block.disc_size = disc_size;
+        super_block.inodes_count = number_of_inodes;
+        super_block.unused_inodes = number_of_inodes;
+        super_block.datablocks_count = number_of_data_blocks;
+        super_block.unused_datablocks = number_of_data_blocks;
+        super_block.data_map_cursor = 0;
+        super_block.inode_offset = sizeof(SuperBlock);
+        super_block.inode_map_offset = inode_map_offset;
+        super_block.inode_map_cursor = 0;
+        super_block.data_map_offset = data_map_offset;
+        super_block.data_block_offset = data_block_offset;
+        super_block.block_size = block_size_;
+        super_block.name_length = name_length_;
+        super_block.files_space = files_space;
+        super_block.magic = DISC_MAGIC;
+        super_block.version = DISC_VERSION;
+
+        load_lengths(super_block);
+
+        INode root{};
+        root.type = INodeType::DIRECTORY_NODE;
+        root.reference_count = 1;
+        u_int64_t root_inode_map = 1;
+        super_block.unused_inodes -= 1;
+
+        if(ftruncate(descriptor, data_block_offset + data_blocks_length * block_size) < 0){
+            std::cout << "Writing to file error";
+            exit(EXIT_FAILURE);
+        }
+        write_range(descriptor, &super_block, sizeof(SuperBlock), 0);
+        write_range(descriptor, &root, sizeof(INode), super_block.inode_offset);
+        write_range(descriptor, &root_inode_map, sizeof(u_int64_t), super_block.inode_map_offset);
+        if(::close(descriptor) < 0){
+            std::cout << "Writing to file error";
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    void open(){
+        auto start = std::chrono::steady_clock::now();
+        open_image();
+        load_snapshots();
+        statistics.open_nanoseconds += get_nanoseconds_since(start);
+    }
+
+    void close(){
+        auto start = std::chrono::steady_clock::now();
+        close_image();
+        statistics.close_nanoseconds += get_nanoseconds_since(start);
+    }
+
+    void record_operation(std::string operation, u_int64_t nanoseconds){
+        statistics.operations[operation].add(nanoseconds);
+    }
+
+    void show_statistics(std::ostream &output){
+        output << "Inode allocations: \x1B[33m" << statistics.inode_allocations << "\033[0m\n";
+        output << "Data block allocations: \x1B[33m" << statistics.data_block_allocations << "\033[0m\n";
+        output << "Extent hops: \x1B[33m" << statistics.extent_hops << "\033[0m\n";
+        output << "Directory entries scanned: \x1B[33m" << statistics.directory_entries_scanned << "\033[0m\n";
+        output << "Bytes read: \x1B[33m" << statistics.bytes_read << "\033[0m\n";
+        output << "Bytes written: \x1B[33m" << statistics.bytes_written << "\033[0m\n";
+        output << "Cache hits: \x1B[33m" << statistics.cache_hits << "\033[0m\n";
+        output << "Cache misses: \x1B[33m" << statistics.cache_misses << "\033[0m\n";
+        output << "Cache evictions: \x1B[33m" << statistics.cache_evictions << "\033[0m\n";
+        output << "Lazily loaded blocks: \x1B[33m" << statistics.lazy_loads << "\033[0m\n";
+        output << "Journal commits: \x1B[33m" << statistics.journal_commits << "\033[0m\n";
+        output << "Journal bytes: \x1B[33m" << statistics.journal_bytes << "\033[0m\n";
+        output << "Open time [us]: \x1B[33m" << statistics.open_nanoseconds / 1000 << "\033[0m\n";
+        output << "Close time [us]: \x1B[33m" << statistics.close_nanoseconds / 1000 << "\033[0m\n";
+        for(auto &[operation, histogram] : statistics.operations){
+            output << "Operation \x1B[34m" << operation << "\033[0m: \x1B[33m" << histogram.count << "\033[0m calls, average \x1B[33m" << histogram.total_nanoseconds / histogram.count / 1000 << "\033[0m us\n";
+            for(u_int64_t bucket = 0; bucket < LATENCY_BUCKETS; bucket++)
+                if(histogram.buckets[bucket])
+                    output << "  < " << (1ull << bucket) << " us: \x1B[33m" << histogram.buckets[bucket] << "\033[0m\n";
+        }
+    }
+
+    static u_int64_t get_nanoseconds_since(std::chrono::steady_clock::time_point start){
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void sync(){
+        write_back();
+    }
+
+    void set_name(std::string file_name){
+        name = file_name;
+    }
+
+    void set_open_mode(OpenMode mode){
+        open_mode = mode;
+    }
+
+    void set_workers_count(u_int64_t count){
+        workers_count = std::max<u_int64_t>(count, 1);
+    }
+
+    void set_cache_size(u_int64_t size){
+        cache_size = size;
+    }
+
+    void release_blocks(){
+        if(open_mode != OpenMode::CACHE_MODE)
+            return;
+        block_cache.release();
+        if(!block_cache.is_over_capacity())
+            return;
+        write_back();
+        block_cache.release();
+    }
+
+    void clear_path_cache(){
+        path_cache.clear();
+        path_cache_entries.clear();
+    }
+
+    void set_io_backend(IOBackend backend, u_int64_t queue_depth, bool direct){
+        block_transfer.setup(backend, queue_depth);
+        direct_io = direct;
+    }
+
+    IOBackend get_io_backend(){
+        return block_transfer.get_backend();
+    }
+
+    void create_directory(std::string pwd){
+        PathTokenizer tokenizer(pwd);
+        std::string_view current_directory_name;
+        INode *current_direcotry_inode = inodes;
+        while(tokenizer.next(current_directory_name)){
+            if(!is_valid_name(current_directory_name)){
+                std::cerr << "Invalid directory name: " << current_directory_name << "\n";
+                exit(EXIT_FAILURE);
+            }
+            INode* next_direcotry_inode = get_inode_in_inode(current_direcotry_inode, current_directory_name);
+            if(next_direcotry_inode && next_direcotry_inode->type == INodeType::DIRECTORY_NODE){
+                current_direcotry_inode = next_direcotry_inode;
+            } else if (next_direcotry_inode){
+                std::cerr << "Missing directory: " << current_directory_name << "\n";
+                return;
+            } else
+                current_direcotry_inode = create_inode_in_directory(current_direcotry_inode, current_directory_name, INodeType::DIRECTORY_NODE);
+            if(!current_directory_name.empty())
+                cache_path(std::string_view(pwd).substr(0, tokenizer.end()), current_direcotry_inode);
+        }
+    }
+
+    void show_files_tree(std::string pwd){
+        shown_direcotry_links.clear();
+        INode *directory = get_direcotry_inode(pwd);
+        if(!directory){
+            std::cerr << "Invalid path\n";
+            exit(EXIT_FAILURE);
+        }
+        return show_files_inode(directory, 0);
+    }
+
+    void file_to_disc(std::string pwd, std::string file_name){
+        INode *direcotry_inode = get_direcotry_inode(pwd);
+        if(!direcotry_inode){
+            std::cerr << "Invalid path";
+            exit(EXIT_FAILURE);
+        }
+        if(get_inode_in_inode(direcotry_inode, file_name)){
+            std::cerr << "FIle alraedy exists";
+            exit(EXIT_FAILURE);
+        }
+        int file_descriptor = ::open(file_name.c_str(), O_RDONLY);
+        struct stat file_stat;
+        if(file_descriptor < 0 || fstat(file_descriptor, &file_stat) < 0){
+            std::cout << "Cannot open file";
+            exit(EXIT_FAILURE);
+        }
+        bool is_regular_file = S_ISREG(file_stat.st_mode);
+        if(is_regular_file && (u_int64_t)file_stat.st_size > get_left_space()){
+            std::cerr << "Lack of empty data blokcs\n";
+            exit(EXIT_FAILURE);
+        }
+
+        INode *inode = create_inode_in_directory(direcotry_inode, file_name, INodeType::FILE_NODE);
+        if(is_regular_file && (u_int64_t)file_stat.st_size <= INODE_INLINE_SIZE)
+            read_file_inline(inode, file_descriptor, file_stat.st_size);
+        else if(is_regular_file){
+            std::vector<u_int64_t> data_blocks = allocate_file_blocks(file_stat.st_size);
+            copy_file_blocks(file_descriptor, data_blocks, file_stat.st_size);
+            attach_file_blocks(inode, data_blocks, file_stat.st_size);
+        }
+        else
+            read_file_to_inode(inode, file_descriptor);
+        ::close(file_descriptor);
+    }
+
+    void directory_to_disc(std::string pwd, std::string directory_name){
+        if(!std::filesystem::is_directory(directory_name)){
+            std::cerr << "Invalid path";
+            exit(EXIT_FAILURE);
+        }
+        INode *direcotry_inode = inodes;
+        PathTokenizer tokenizer(pwd);
+        std::string_view directory;
+        while(direcotry_inode && tokenizer.next(directory)){
+            INode *inode = get_inode_in_inode(direcotry_inode, directory);
+            if(inode && inode->type != INodeType::DIRECTORY_NODE){
+                std::cerr << "Invalid path";
+                exit(EXIT_FAILURE);
+            }
+            direcotry_inode = inode;
+        }
+        u_int64_t blocks_count = 0;
+        check_host_directory(direcotry_inode, directory_name, blocks_count);
+        if(blocks_count * block_size > get_left_space()){
+            std::cerr << "Lack of empty data blokcs\n";
+            exit(EXIT_FAILURE);
+        }
+        create_directory(pwd);
+        direcotry_inode = get_direcotry_inode(pwd);
+        if(!direcotry_inode || direcotry_inode->type != INodeType::DIRECTORY_NODE){
+            std::cerr << "Invalid path";
+            exit(EXIT_FAILURE);
+        }
+        std::vector<FileCopyJob> jobs;
+        directory_to_inode(direcotry_inode, directory_name, jobs);
+        std::atomic<bool> failed{false};
+        WorkerPool<FileCopyJob> workers(workers_count, [this, &failed](FileCopyJob &job){
+            int file_descriptor = ::open(job.file_name.c_str(), O_RDONLY);
+            struct stat file_stat;
+            if(file_descriptor < 0 || fstat(file_descriptor, &file_stat) < 0 || (u_int64_t)file_stat.st_size != job.size){
+                failed = true;
+                if(file_descriptor >= 0)
+                    ::close(file_descriptor);
+                return;
+            }
+            copy_file_blocks(file_descriptor, job.data_blocks, job.size);
+            ::close(file_descriptor);
+        });
+        for(auto &job : jobs)
+            workers.push(job);
+        workers.wait();
+        if(failed){
+            std::cout << "Cannot open file";
+            exit(EXIT_FAILURE);
+        }
+        for(auto &job : jobs)
+            attach_file_blocks(job.inode, job.data_blocks, job.size);
+    }
+
+    void file_from_disc(std::string pwd, std::string file_name_destination){
+        inode_to_file(get_inode_by_pwd(pwd), file_name_destination);
+    }
+
+    void directory_from_disc(std::string pwd, std::string directory_name_destination){
+        INode *direcotry_inode = get_direcotry_inode(pwd);
+        if(!direcotry_inode || direcotry_inode->type != INodeType::DIRECTORY_NODE){
+            std::cerr << "Invalid path";
+            exit(EXIT_FAILURE);
+        }
+        WorkerPool<FileExportJob> workers(workers_count, [this](FileExportJob &job){
+            inode_to_file(job.inode, job.file_name);
+        });
+        std::set<INode*> exported_directories;
+        inode_to_directory(direcotry_inode, directory_name_destination, exported_directories, workers);
+        workers.wait();
+    }
+
+    u_int64_t get_left_space(){
+        u_int64_t frozen_blocks = 0;
+        for(u_int64_t idx = 0; idx < frozen_maps.size(); idx++)
+            frozen_blocks += __builtin_popcountll(frozen_maps[idx] & ~data_maps[idx]);
+        return ((u_int64_t)super_block.unused_datablocks - frozen_blocks) * block_size;
+    }
+
+    u_int64_t get_size(std::string pwd){
+        INode *direcotry = get_direcotry_inode(pwd);
+        if(!direcotry){
+            std::cerr << "Invalid path";
+            exit(EXIT_FAILURE);
+        }
+        u_int64_t size = 0;
+        for_each_data_block(direcotry, [&](u_int64_t data_block_idx){
+            for_each_link_in_block(data_block_idx, [&](DirectoryLink *direcotry_link, u_int64_t){
+                if(direcotry_link->used)
+                   size += inodes[direcotry_link->inode_id].size;
+            });
+            return true;
+        });
+        return size;
+    }
+
+    u_int64_t get_full_size(std::string pwd){
+        shown_inodes.clear();
+        INode *directory = get_direcotry_inode(pwd);
+        if(!directory){
+            std::cerr << "Invalid path";
+            exit(EXIT_FAILURE);
+        }
+        return get_size_inode(directory);
+    }
+
+    void create_link(std::string pwd, std::string link_pwd){
+        INode* file = get_inode_by_pwd(pwd);
+        std::string_view link_path, link_file_name;
+        split_parent(link_pwd, link_path, link_file_name);
+        INode *link_directory_inode = get_direcotry_inode(link_path);
+        if(!link_directory_inode){
+            std::cerr << "Invalid path";
+            exit(EXIT_FAILURE);
+        }
+        if(get_inode_in_inode(link_directory_inode, link_file_name)){
+            std::cerr << "FIle alraedy exists";
+            exit(EXIT_FAILURE);
+        }
+        file->reference_count += 1;
+        mark_dirty_inode(file);
+        link_inode_in_directory(link_directory_inode, link_file_name, file - inodes);
+    }
+
+    void clone_file(std::string pwd, std::string clone_pwd){
+        INode *file = get_inode_by_pwd(pwd);
+        if(file->type != INodeType::FILE_NODE){
+            std::cerr << "Not a file";
+            exit(EXIT_FAILURE);
+        }
+        std::string_view clone_path, clone_file_name;
+        split_parent(clone_pwd, clone_path, clone_file_name);
+        INode *clone_directory_inode = get_direcotry_inode(clone_path);
+        if(!clone_directory_inode){
+            std::cerr << "Invalid path";
+            exit(EXIT_FAILURE);
+        }
+        if(!is_valid_name(clone_file_name)){
+            std::cerr << "Invalid file name";
+            exit(EXIT_FAILURE);
+        }
+        if(get_inode_in_inode(clone_directory_inode, clone_file_name)){
+            std::cerr << "FIle alraedy exists";
+            exit(EXIT_FAILURE);
+        }
+        INode *clone = create_inode_in_directory(clone_directory_inode, clone_file_name, INodeType::FILE_NODE);
+        u_int32_t reference_count = clone->reference_count;
+        *clone = *file;
+        clone->reference_count = reference_count;
+        if(!is_inline(file)){
+            file->flags |= INODE_SHARED;
+            clone->flags |= INODE_SHARED;
+            if(shared_references_loaded)
+                for_each_extent_range(&file->extent_header, file->extents, [&](u_int64_t data_block_idx, u_int64_t length){
+                    add_shared_references(data_block_idx, length);
+                });
+        }
+        mark_dirty_inode(file);
+        mark_dirty_inode(clone);
+    }
+
+    void convert_from_v1(std::string file_name){
+        DiscV1Reader old_disc;
+        if(!old_disc.open(file_name)){
+            std::cerr << "Not a version 1 disc";
+            exit(EXIT_FAILURE);
+        }
+        std::string converted_name = file_name + ".v2";
+        SuperBlockV1 *old_super_block = old_disc.super_block;
+        create(converted_name, old_super_block->disc_size, DATA_BLOCK_SIZE, NAME_LENGTH, FILES_SPACE);
+        open();
+        memcpy(super_block.name, old_super_block->name, NAME_LENGTH);
+        std::unordered_map<u_int64_t, u_int64_t> converted_inodes{{0, 0}};
+        convert_directory_v1(old_disc, old_disc.inodes, inodes, converted_inodes);
+        close();
+        if(rename(converted_name.c_str(), file_name.c_str()) < 0){
+            std::cout << "Writing to file error";
+            exit(EXIT_FAILURE);
+        }
+        name = file_name;
+    }
+
+    void create_snapshot(std::string snapshot_name){
+        check_snapshot_name(snapshot_name);
+        if(access(get_snapshot_name(snapshot_name).c_str(), F_OK) == 0){
+            std::cerr << "Snapshot already exists";
+            exit(EXIT_FAILURE);
+        }
+        sync();
+        std::string staged_name = name + ".snapshot-new";
+        int descriptor = ::open(staged_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if(descriptor < 0){
+            std::cout << "Cannot open file";
+            exit(EXIT_FAILURE);
+        }
+        u_int64_t inodes_size = inodes_length * sizeof(INode);
+        u_int64_t inode_maps_size = inode_maps_length * sizeof(u_int64_t);
+        write_range(descriptor, &super_block, sizeof(SuperBlock), 0);
+        write_range(descriptor, inodes, inodes_size, sizeof(SuperBlock));
+        write_range(descriptor, inode_maps, inode_maps_size, sizeof(SuperBlock) + inodes_size);
+        write_range(descriptor, data_maps, data_maps_length * sizeof(u_int64_t), sizeof(SuperBlock) + inodes_size + inode_maps_size);
+        if(fdatasync(descriptor) < 0 || ::close(descriptor) < 0 || rename(staged_name.c_str(), get_snapshot_name(snapshot_name).c_str()) < 0){
+            std::cout << "Writing to file error";
+            exit(EXIT_FAILURE);
+        }
+        std::filesystem::path image(name);
+        int directory_descriptor = ::open(image.has_parent_path() ? image.parent_path().c_str() : ".", O_RDONLY | O_DIRECTORY);
+        if(directory_descriptor >= 0){
+            fsync(directory_descriptor);
+            ::close(directory_descriptor);
+        }
+        freeze_data_blocks(data_maps);
+    }
+
+    void remove_snapshot(std::string snapshot_name){
+        check_snapshot_name(snapshot_name);
+        if(unlink(get_snapshot_name(snapshot_name).c_str()) < 0){
+            std::cerr << "Missing snapshot";
+            exit(EXIT_FAILURE);
+        }
+        load_snapshots();
+    }
+
+    void rollback_snapshot(std::string snapshot_name){
+        check_snapshot_name(snapshot_name);
+        std::vector<u_int8_t> snapshot;
+        int descriptor = ::open(get_snapshot_name(snapshot_name).c_str(), O_RDONLY);
+        struct stat snapshot_stat;
+        if(descriptor < 0 || fstat(descriptor, &snapshot_stat) < 0){
+            std::cerr << "Missing snapshot";
+            exit(EXIT_FAILURE);
+        }
+        if((u_int64_t)snapshot_stat.st_size != get_snapshot_size()){
+            std::cerr << "Invalid snapshot";
+            exit(EXIT_FAILURE);
+        }
+        snapshot.resize(snapshot_stat.st_size);
+        read_range(descriptor, snapshot.data(), snapshot.size(), 0);
+        ::close(descriptor);
+        SuperBlock *snapshot_super_block = (SuperBlock*)snapshot.data();
+        INode *snapshot_inodes = (INode*)(snapshot_super_block + 1);
+        u_int64_t *snapshot_inode_maps = (u_int64_t*)(snapshot_inodes + inodes_length);
+        u_int64_t *snapshot_data_maps = snapshot_inode_maps + inode_maps_length;
+        if(snapshot_super_block->magic != DISC_MAGIC || snapshot_super_block->inodes_count != super_block.inodes_count || snapshot_super_block->datablocks_count != super_block.datablocks_count || snapshot_super_block->block_size != super_block.block_size || snapshot_super_block->name_length != super_block.name_length){
+            std::cerr << "Invalid snapshot";
+            exit(EXIT_FAILURE);
+        }
+        memcpy(snapshot_super_block->name, super_block.name, NAME_LENGTH);
+        super_block = *snapshot_super_block;
+        for(u_int64_t idx = 0; idx < inodes_length; idx++)
+            if(memcmp(&inodes[idx], &snapshot_inodes[idx], sizeof(INode))){
+                inodes[idx] = snapshot_inodes[idx];
+                mark_dirty_inode(&inodes[idx]);
+            }
+        for(u_int64_t idx = 0; idx < inode_maps_length; idx++)
+            if(inode_maps[idx] != snapshot_inode_maps[idx]){
+                inode_maps[idx] = snapshot_inode_maps[idx];
+                dirty_inode_maps.insert(idx);
+            }
+        for(u_int64_t idx = 0; idx < data_maps_length; idx++)
+            if(data_maps[idx] != snapshot_data_maps[idx]){
+                data_maps[idx] = snapshot_data_maps[idx];
+                dirty_data_maps.insert(idx);
+            }
+        directory_indexes.clear();
+        clear_path_cache();
+        shared_references.clear();
+        shared_references_loaded = false;
+    }
+
+    void show_information(std::string pwd){
+        std::cout << "Information about: \x1B[34m" << pwd << "\033[0m\n";
+        std::cout << "Files size: \x1B[33m" << get_size(pwd) << "\033[0m\n";
+        std::cout << "Full size: \x1B[33m" << get_full_size(pwd) << "\033[0m\n";
+        std::cout << "Left space: \x1B[33m" << get_left_space() << "\033[0m\n";
+    }
+
+    void remove_link(std::string pwd){
+        std::string_view path, file_name;
+        split_parent(pwd, path, file_name);
+        INode *direcotry_inode = get_direcotry_inode(path);
+        if(!direcotry_inode){
+            std::cerr << "Invalid path";
+            exit(EXIT_FAILURE);
+        }
+        INode *file= get_inode_in_inode(direcotry_inode, file_name);
+        if(!file){
+            std::cerr << "Missing file";
+            exit(EXIT_FAILURE);
+        }
+        clear_path_cache();
+        remove_inode(file);
+        remove_link_from_inode(direcotry_inode, file_name);
+    }
+
+    void cut_file(std::string pwd , size_t size_to_cut){
+        INode* file = get_inode_by_pwd(pwd);
+        if(file->size < size_to_cut){
+            std::cerr << "Size to cut greater than file's size";
+            exit(EXIT_FAILURE);
+        }
+        file->size -= size_to_cut;
+        mark_dirty_inode(file);
+        if(is_inline(file))
+            memset(get_inline_data(file) + file->size, 0, size_to_cut);
+        truncate_data_blocks(file, (file->size + block_size - 1) / block_size);
+    }
+
+    void extend_file(std::string pwd, size_t size_to_extend){
+        INode* file = get_inode_by_pwd(pwd);
+        extend_inode(file, size_to_extend);
+    }
+
+    u_int64_t read_file(std::string pwd, u_int64_t offset, u_int8_t *buffer, u_int64_t length){
+        INode* file = get_inode_by_pwd(pwd);
+        if(file->type != INodeType::FILE_NODE){
+            std::cerr << "Not a file";
+            exit(EXIT_FAILURE);
+        }
+        if(offset >= file->size)
+            return 0;
+        length = std::min(length, file->size - offset);
+        statistics.bytes_read += length;
+        if(is_inline(file)){
+            memcpy(buffer, get_inline_data(file) + offset, length);
+            return length;
+        }
+        u_int64_t done = 0;
+        while(done < length){
+            u_int64_t block_offset = (offset + done) % block_size;
+            u_int64_t current_size = std::min(length - done, block_size - block_offset);
+            u_int64_t data_block_idx = get_file_block(file, (offset + done) / block_size);
+            memcpy(buffer + done, get_data_block(data_block_idx) + block_offset, current_size);
+            done += current_size;
+        }
+        return length;
+    }
+
+    void write_file(std::string pwd, u_int64_t offset, const u_int8_t *bytes, u_int64_t length){
+        INode* file = get_inode_by_pwd(pwd);
+        if(file->type != INodeType::FILE_NODE){
+            std::cerr << "Not a file";
+            exit(EXIT_FAILURE);
+        }
+        if(!is_inline(file) || offset + length > INODE_INLINE_SIZE)
+            check_writable_blocks(file, offset / block_size, (offset + length + block_size - 1) / block_size);
+        if(offset + length > file->size)
+            extend_inode(file, offset + length - file->size);
+        statistics.bytes_written += length;
+        if(is_inline(file)){
+            memcpy(get_inline_data(file) + offset, bytes, length);
+            mark_dirty_inode(file);
+            return;
+        }
+        u_int64_t done = 0;
+        while(done < length){
+            u_int64_t block_offset = (offset + done) % block_size;
+            u_int64_t current_size = std::min(length - done, block_size - block_offset);
+            u_int64_t data_block_idx = get_writable_file_block(file, (offset + done) / block_size);
+            memcpy(get_data_block(data_block_idx) + block_offset, bytes + done, current_size);
+            mark_dirty_data_block(data_block_idx);
+            done += current_size;
+        }
+    }
+
+private:
+    void extend_inode(INode* file, u_int64_t size_to_extend){
+        if(is_inline(file) && file->size + size_to_extend <= INODE_INLINE_SIZE){
+            memset(get_inline_data(file) + file->size, 0, size_to_extend);
+            file->size += size_to_extend;
+            mark_dirty_inode(file);
+            return;
+        }
+        check_writable_blocks(file, file->size / block_size, (file->size + size_to_extend + block_size - 1) / block_size);
+        if(is_inline(file))
+            move_inline_data_to_block(file);
+        u_int64_t last_datablock_size = file->size % block_size;
+        if(last_datablock_size > 0){
+            u_int64_t last_datablock_idx = get_writable_file_block(file, file->blocks_count - 1);
+            u_int64_t current_size_to_extend = block_size - last_datablock_size;
+            if(current_size_to_extend > size_to_extend)
+                current_size_to_extend = size_to_extend;
+            memset(get_data_block(last_datablock_idx) + last_datablock_size * sizeof(u_int8_t), 0, current_size_to_extend);
+            mark_dirty_data_block(last_datablock_idx);
+            size_to_extend -= current_size_to_extend;
+            file->size += current_size_to_extend;
+        }
+        while(size_to_extend > 0){
+            u_int64_t new_size;
+            if(size_to_extend > block_size)
+                new_size = block_size;
+            else
+                new_size = size_to_extend;
+            append_data_block(file, get_empty_data_block());
+            size_to_extend -= new_size;
+            file->size += new_size;
+            release_blocks();
+        }
+        mark_dirty_inode(file);
+    }
+
+    void check_writable_blocks(INode *file, u_int64_t first_block, u_int64_t last_block){
+        u_int64_t new_blocks = last_block > file->blocks_count ? last_block - file->blocks_count : 0;
+        u_int64_t shared_blocks = 0;
+        u_int64_t depth = is_inline(file) ? 0 : file->extent_header.depth;
+        if(new_blocks > 0 && file->blocks_count > 0)
+            first_block = std::min(first_block, file->blocks_count - 1);
+        if(!is_inline(file) && (!frozen_maps.empty() || file->flags & INODE_SHARED)){
+            if(file->flags & INODE_SHARED)
+                load_shared_references();
+            shared_blocks = count_shared_blocks(&file->extent_header, file->extents, first_block, std::min(last_block, file->blocks_count));
+        }
+        u_int64_t needed_blocks = new_blocks + new_blocks / (extents_in_block - 1) + shared_blocks + 4 * shared_blocks / (extents_in_block / 2) + depth + 2;
+        if(needed_blocks * block_size > get_left_space()){
+            std::cerr << "Lack of empty data blokcs\n";
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    u_int64_t count_shared_blocks(ExtentHeader *header, Extent *extents, u_int64_t first_block, u_int64_t last_block){
+        u_int64_t count = 0;
+        for(u_int64_t idx = 0; idx < header->count; idx++){
+            u_int64_t start = extents[idx].file_block;
+            u_int64_t end = header->depth == 0 ? start + extents[idx].length : idx + 1 < header->count ? extents[idx + 1].file_block : (u_int64_t)-1;
+            if(end <= first_block || start >= last_block)
+                continue;
+            if(header->depth == 0){
+                for(u_int64_t block = std::max(start, first_block); block < std::min(end, last_block); block++)
+                    count += is_shared_block(extents[idx].data_block_index + block - start);
+                continue;
+            }
+            count += is_shared_block(extents[idx].data_block_index);
+            ExtentHeader *child = get_extent_node(extents[idx].data_block_index);
+            count += count_shared_blocks(child, (Extent*)(child + 1), first_block, last_block);
+        }
+        return count;
+    }
+
+    void open_image(){
+        dirty_inodes.clear();
+        dirty_inode_maps.clear();
+        dirty_data_maps.clear();
+        dirty_data_blocks.clear();
+        directory_indexes.clear();
+        clear_path_cache();
+        replay_journal();
+        if(open_mode == OpenMode::MMAP_MODE)
+            return open_mapped();
+        int descriptor = ::open(name.c_str(), open_mode == OpenMode::CACHE_MODE ? O_RDWR : O_RDONLY);
+        if(descriptor < 0){
+            std::cout << "Cannot open file";
+            exit(EXIT_FAILURE);
+        }
+        read_range(descriptor, &super_block, sizeof(SuperBlock), 0);
+        check_version();
+        load_lengths(super_block);
+        committed_super_block = super_block;
+        if(open_mode == OpenMode::CACHE_MODE || open_mode == OpenMode::LAZY_MODE){
+            map_metadata(descriptor);
+            committed_data_maps.assign(data_maps, data_maps + data_maps_length);
+            image_descriptor = descriptor;
+        }
+        if(open_mode == OpenMode::CACHE_MODE){
+            block_cache.open(descriptor, super_block.data_block_offset, block_size, cache_size / block_size, &committed_data_maps, &statistics);
+            return;
+        }
+        void *address = mmap(NULL, data_blocks_length * block_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if(address == MAP_FAILED){
+            std::cout << "Cannot map file";
+            exit(EXIT_FAILURE);
+        }
+        data_blocks = (u_int8_t*)address;
+        if(open_mode == OpenMode::LAZY_MODE){
+            loaded_maps.assign(MAP_WORDS(data_blocks_length), 0);
+            return;
+        }
+        inodes = new INode[inodes_length];
+        inode_maps = new u_int64_t[inode_maps_length];
+        data_maps = new u_int64_t[data_maps_length];
+        std::vector<BlockRequest> requests{
+            {descriptor, (u_int8_t*)inodes, inodes_length * sizeof(INode), super_block.inode_offset, false},
+            {descriptor, (u_int8_t*)inode_maps, inode_maps_length * sizeof(u_int64_t), super_block.inode_map_offset, false},
+            {descriptor, (u_int8_t*)data_maps, data_maps_length * sizeof(u_int64_t), super_block.data_map_offset, false}
+        };
+        int direct_descriptor = open_direct(O_RDONLY);
+        requests.push_back({direct_descriptor < 0 ? descriptor : direct_descriptor, data_blocks, data_blocks_length * block_size, super_block.data_block_offset, false});
+        block_transfer.run(requests);
+        committed_data_maps.assign(data_maps, data_maps + data_maps_length);
+        if(direct_descriptor >= 0)
+            ::close(direct_descriptor);
+        ::close(descriptor);
+    }
+
+    std::string get_snapshot_name(std::string snapshot_name){
+        return name + ".snapshot." + snapshot_name;
+    }
+
+    void check_snapshot_name(std::string_view snapshot_name){
+        if(snapshot_name.empty() || snapshot_name.find('/') != std::string_view::npos){
+            std::cerr << "Invalid snapshot name";
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    u_int64_t get_snapshot_size(){
+        return sizeof(SuperBlock) + inodes_length * sizeof(INode) + (inode_maps_length + data_maps_length) * sizeof(u_int64_t);
+    }
+
+    void for_each_snapshot(std::function<void(const std::filesystem::path&)> visit){
+        std::filesystem::path image(name);
+        std::string prefix = image.filename().string() + ".snapshot.";
+        std::error_code error;
+        for(auto &entry : std::filesystem::directory_iterator(image.has_parent_path() ? image.parent_path() : ".", error))
+            if(entry.path().filename().string().rfind(prefix, 0) == 0)
+                visit(entry.path());
+    }
+
+    void load_snapshots(){
+        frozen_maps.clear();
+        std::vector<u_int64_t> snapshot_maps(data_maps_length);
+        for_each_snapshot([&](const std::filesystem::path &snapshot){
+            int descriptor = ::open(snapshot.c_str(), O_RDONLY);
+            struct stat snapshot_stat;
+            SuperBlock snapshot_super_block{};
+            if(descriptor >= 0 && fstat(descriptor, &snapshot_stat) == 0 && (u_int64_t)snapshot_stat.st_size == get_snapshot_size())
+                read_range(descriptor, &snapshot_super_block, sizeof(SuperBlock), 0);
+            if(snapshot_super_block.magic != DISC_MAGIC || snapshot_super_block.datablocks_count != super_block.datablocks_count){
+                std::cerr << "Skipping invalid snapshot: " << snapshot.string() << "\n";
+                if(descriptor >= 0)
+                    ::close(descriptor);
+                return;
+            }
+            read_range(descriptor, snapshot_maps.data(), data_maps_length * sizeof(u_int64_t), get_snapshot_size() - data_maps_length * sizeof(u_int64_t));
+            ::close(descriptor);
+            freeze_data_blocks(snapshot_maps.data());
+        });
+    }
+
+    void freeze_data_blocks(const u_int64_t *maps){
+        if(frozen_maps.empty())
+            frozen_maps.assign(data_maps_length, 0);
+        for(u_int64_t idx = 0; idx < data_maps_length; idx++)
+            frozen_maps[idx] |= maps[idx];
+    }
+
+    int open_direct(int flags){
+        if(!direct_io || block_size % DATA_ALIGNMENT || super_block.data_block_offset % DATA_ALIGNMENT)
+            return -1;
+        return ::open(name.c_str(), flags | O_DIRECT);
+    }
+
+    void close_image(){
+        if(open_mode == OpenMode::MMAP_MODE)
+            return close_mapped();
+        write_back();
+        finish_journal();
+        if(open_mode == OpenMode::STREAM_MODE){
+            delete[] inodes;
+            delete[] inode_maps;
+            delete[] data_maps;
+        } else{
+            munmap(mapping, mapping_size);
+            mapping = NULL;
+        }
+        if(open_mode == OpenMode::CACHE_MODE)
+            block_cache.close();
+        else
+            munmap(data_blocks, data_blocks_length * block_size);
+        if(open_mode == OpenMode::CACHE_MODE || open_mode == OpenMode::LAZY_MODE){
+            ::close(image_descriptor);
+            image_descriptor = -1;
+        }
+        loaded_maps.clear();
+        committed_data_maps.clear();
+    }
+
+    void map_metadata(int descriptor){
+        struct stat file_stat;
+        if(fstat(descriptor, &file_stat) < 0 || (u_int64_t)file_stat.st_size < super_block.data_block_offset){
+            std::cout << "Invalid disc file";
+            exit(EXIT_FAILURE);
+        }
+        mapping_size = super_block.data_block_offset;
+        void *address = mmap(NULL, mapping_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_NORESERVE, descriptor, 0);
+        if(address == MAP_FAILED){
+            std::cout << "Cannot map file";
+            exit(EXIT_FAILURE);
+        }
+        mapping = (u_int8_t*)address;
+        inodes = (INode*)(mapping + super_block.inode_offset);
+        inode_maps = (u_int64_t*)(mapping + super_block.inode_map_offset);
+        data_maps = (u_int64_t*)(mapping + super_block.data_map_offset);
+    }
+
+    void open_mapped(){
+        int descriptor = ::open(name.c_str(), O_RDWR);
+        if(descriptor < 0){
+            std::cout << "Cannot open file";
+            exit(EXIT_FAILURE);
+        }
+        struct stat file_stat;
+        if(fstat(descriptor, &file_stat) < 0 || (u_int64_t)file_stat.st_size < sizeof(SuperBlock)){
+            std::cout << "Invalid disc file";
+            exit(EXIT_FAILURE);
+        }
+        mapping_size = file_stat.st_size;
+        void *address = mmap(NULL, mapping_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_NORESERVE, descriptor, 0);
+        if(address == MAP_FAILED){
+            std::cout << "Cannot map file";
+            exit(EXIT_FAILURE);
+        }
+        mapping = (u_int8_t*)address;
+        image_descriptor = descriptor;
+        memcpy(&super_block, mapping, sizeof(SuperBlock));
+        check_version();
+        load_lengths(super_block);
+        if(super_block.data_block_offset + data_blocks_length * block_size > mapping_size){
+            std::cout << "Invalid disc file";
+            exit(EXIT_FAILURE);
+        }
+        inodes = (INode*)(mapping + super_block.inode_offset);
+        inode_maps = (u_int64_t*)(mapping + super_block.inode_map_offset);
+        data_maps = (u_int64_t*)(mapping + super_block.data_map_offset);
+        data_blocks = mapping + super_block.data_block_offset;
+        committed_super_block = super_block;
+        committed_data_maps.assign(data_maps, data_maps + data_maps_length);
+    }
+
+    void write_back(){
+        int descriptor = ::open(name.c_str(), O_WRONLY);
+        if(descriptor < 0){
+            std::cout << "Cannot open file";
+            exit(EXIT_FAILURE);
+        }
+        int direct_descriptor = open_direct(O_WRONLY);
+        if(open_mode == OpenMode::LAZY_MODE)
+            for(auto it = dirty_data_blocks.begin(); it != dirty_data_blocks.end();)
+                it = is_block_loaded(*it) ? std::next(it) : dirty_data_blocks.erase(it);
+        std::vector<BlockRequest> requests, data_requests;
+        if(memcmp(&super_block, &committed_super_block, sizeof(SuperBlock)))
+            requests.push_back({descriptor, (u_int8_t*)&super_block, sizeof(SuperBlock), 0, true});
+        for_each_dirty_range(dirty_inodes, [&](u_int64_t start, u_int64_t count){
+            requests.push_back({descriptor, (u_int8_t*)&inodes[start], count * sizeof(INode), super_block.inode_offset + start * sizeof(INode), true});
+        });
+        for_each_dirty_range(dirty_inode_maps, [&](u_int64_t start, u_int64_t count){
+            requests.push_back({descriptor, (u_int8_t*)&inode_maps[start], count * sizeof(u_int64_t), super_block.inode_map_offset + start * sizeof(u_int64_t), true});
+        });
+        for_each_dirty_range(dirty_data_maps, [&](u_int64_t start, u_int64_t count){
+            requests.push_back({descriptor, (u_int8_t*)&data_maps[start], count * sizeof(u_int64_t), super_block.data_map_offset + start * sizeof(u_int64_t), true});
+        });
+        for_each_dirty_range(dirty_data_blocks, [&](u_int64_t start, u_int64_t count){
+            add_data_block_requests({direct_descriptor < 0 ? descriptor : direct_descriptor, get_data_block(start), count * block_size, get_data_block_offset(start), true}, requests, data_requests);
+        });
+        if(open_mode == OpenMode::CACHE_MODE)
+            for(auto &request : block_cache.flush())
+                add_data_block_requests(request, requests, data_requests);
+        block_transfer.run(data_requests);
+        if(!requests.empty())
+            commit_journal(descriptor, requests);
+        if(direct_descriptor >= 0)
+            ::close(direct_descriptor);
+        if(::close(descriptor) < 0){
+            std::cout << "Writing to file error";
+            exit(EXIT_FAILURE);
+        }
+        committed_super_block = super_block;
+        committed_data_maps.assign(data_maps, data_maps + data_maps_length);
+        dirty_inodes.clear();
+        dirty_inode_maps.clear();
+        dirty_data_maps.clear();
+        dirty_data_blocks.clear();
+    }
+
+    void add_data_block_requests(BlockRequest request, std::vector<BlockRequest> &journal_requests, std::vector<BlockRequest> &data_requests){
+        u_int64_t first = (request.offset - super_block.data_block_offset) / block_size;
+        u_int64_t count = request.size / block_size;
+        for(u_int64_t idx = 0; idx < count;){
+            bool committed = is_map_bit_set(committed_data_maps.data(), first + idx);
+            u_int64_t last = idx + 1;
+            while(last < count && is_map_bit_set(committed_data_maps.data(), first + last) == committed)
+                last++;
+            BlockRequest run{request.descriptor, request.buffer + idx * block_size, (last - idx) * block_size, request.offset + idx * block_size, true};
+            (committed ? journal_requests : data_requests).push_back(run);
+            idx = last;
+        }
+    }
+
+    std::string get_journal_name(){
+        return name + ".journal";
+    }
+
+    static u_int64_t get_checksum(const void *buffer, u_int64_t size, u_int64_t checksum = 0xcbf29ce484222325ull){
+        const u_int8_t *bytes = (const u_int8_t*)buffer;
+        for(u_int64_t idx = 0; idx < size; idx++)
+            checksum = (checksum ^ bytes[idx]) * 0x100000001b3ull;
+        return checksum;
+    }
+
+    void commit_journal(int descriptor, const std::vector<BlockRequest> &requests){
+        if(fdatasync(descriptor) < 0){
+            std::cout << "Writing to file error";
+            exit(EXIT_FAILURE);
+        }
+        int journal_descriptor = ::open(get_journal_name().c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if(journal_descriptor < 0){
+            std::cout << "Cannot open file";
+            exit(EXIT_FAILURE);
+        }
+        std::vector<JournalEntry> entries;
+        u_int64_t payload_size = 0;
+        for(auto &request : requests){
+            entries.push_back(JournalEntry{request.offset, request.size});
+            payload_size += request.size;
+        }
+        u_int64_t entries_size = entries.size() * sizeof(JournalEntry);
+        u_int64_t checksum = get_checksum(entries.data(), entries_size);
+        write_range(journal_descriptor, entries.data(), entries_size, sizeof(JournalHeader));
+        u_int64_t journal_offset = sizeof(JournalHeader) + entries_size;
+        for(auto &request : requests){
+            checksum = get_checksum(request.buffer, request.size, checksum);
+            write_range(journal_descriptor, request.buffer, request.size, journal_offset);
+            journal_offset += request.size;
+        }
+        JournalHeader header{JOURNAL_MAGIC, entries.size(), payload_size, checksum};
+        write_range(journal_descriptor, &header, sizeof(JournalHeader), 0);
+        if(fdatasync(journal_descriptor) < 0 || ::close(journal_descriptor) < 0){
+            std::cout << "Writing to file error";
+            exit(EXIT_FAILURE);
+        }
+        block_transfer.run(requests);
+        checkpoint_pending = true;
+        statistics.journal_commits++;
+        statistics.journal_bytes += journal_offset;
+    }
+
+    void finish_journal(){
+        if(!checkpoint_pending)
+            return;
+        int descriptor = ::open(name.c_str(), O_WRONLY);
+        if(descriptor < 0 || fdatasync(descriptor) < 0 || ::close(descriptor) < 0){
+            std::cout << "Writing to file error";
+            exit(EXIT_FAILURE);
+        }
+        unlink(get_journal_name().c_str());
+        checkpoint_pending = false;
+    }
+
+    void replay_journal(){
+        int journal_descriptor = ::open(get_journal_name().c_str(), O_RDONLY);
+        if(journal_descriptor < 0)
+            return;
+        struct stat journal_stat;
+        JournalHeader header{};
+        if(fstat(journal_descriptor, &journal_stat) < 0 || (u_int64_t)journal_stat.st_size < sizeof(JournalHeader))
+            journal_stat.st_size = 0;
+        else
+            read_range(journal_descriptor, &header, sizeof(JournalHeader), 0);
+        u_int64_t journal_size = journal_stat.st_size;
+        if(header.magic != JOURNAL_MAGIC || header.entries_count > journal_size / sizeof(JournalEntry)
+            || sizeof(JournalHeader) + header.entries_count * sizeof(JournalEntry) + header.payload_size != journal_size){
+            ::close(journal_descriptor);
+            unlink(get_journal_name().c_str());
+            return;
+        }
+        std::vector<JournalEntry> entries(header.entries_count);
+        u_int64_t entries_size = entries.size() * sizeof(JournalEntry);
+        read_range(journal_descriptor, entries.data(), entries_size, sizeof(JournalHeader));
+        u_int64_t checksum = get_checksum(entries.data(), entries_size);
+        u_int64_t payload_offset = sizeof(JournalHeader) + entries_size;
+        std::vector<u_int8_t> chunk(TRANSFER_CHUNK_SIZE);
+        for(u_int64_t done = 0; done < header.payload_size;){
+            u_int64_t current_size = std::min<u_int64_t>(chunk.size(), header.payload_size - done);
+            read_range(journal_descriptor, chunk.data(), current_size, payload_offset + done);
+            checksum = get_checksum(chunk.data(), current_size, checksum);
+            done += current_size;
+        }
+        u_int64_t entries_payload = 0;
+        for(auto &entry : entries)
+            entries_payload += entry.size;
+        if(checksum != header.checksum || entries_payload != header.payload_size){
+            ::close(journal_descriptor);
+            unlink(get_journal_name().c_str());
+            return;
+        }
+        int descriptor = ::open(name.c_str(), O_WRONLY);
+        if(descriptor < 0){
+            std::cout << "Cannot open file";
+            exit(EXIT_FAILURE);
+        }
+        for(auto &entry : entries)
+            for(u_int64_t done = 0; done < entry.size;){
+                u_int64_t current_size = std::min<u_int64_t>(chunk.size(), entry.size - done);
+                read_range(journal_descriptor, chunk.data(), current_size, payload_offset);
+                write_range(descriptor, chunk.data(), current_size, entry.offset + done);
+                payload_offset += current_size;
+                done += current_size;
+            }
+        ::close(journal_descriptor);
+        if(fdatasync(descriptor) < 0 || ::close(descriptor) < 0){
+            std::cout << "Writing to file error";
+            exit(EXIT_FAILURE);
+        }
+        unlink(get_journal_name().c_str());
+    }
+
+    void close_mapped(){
+        write_back();
+        finish_journal();
+        if(munmap(mapping, mapping_size) < 0){
+            std::cout << "Writing to file error";
+            exit(EXIT_FAILURE);
+        }
+        mapping = NULL;
+        ::close(image_descriptor);
+        image_descriptor = -1;
+        committed_data_maps.clear();
+    }
+
+    u_int64_t get_data_block_offset(u_int64_t data_block_idx){
+        return super_block.data_block_offset + data_block_idx * block_size;
+    }
+
+    void read_file_to_inode(INode *inode, int file_descriptor){
+        std::vector<u_int8_t> buffer(block_size);
+        while(true){
+            u_int64_t read_block_size = 0;
+            while(read_block_size < block_size){
+                ssize_t read_size = ::read(file_descriptor, buffer.data() + read_block_size, block_size - read_block_size);
+                if(read_size < 0){
+                    std::cerr << "Invalid file";
+                    exit(EXIT_FAILURE);
+                }
+                if(read_size == 0)
+                    break;
+                read_block_size += read_size;
+            }
+            if(read_block_size == 0)
+                return;
+            u_int64_t data_block_idx = get_empty_data_block(read_block_size < block_size);
+            if(read_block_size < block_size)
+                memcpy(get_data_block(data_block_idx), buffer.data(), read_block_size);
+            else
+                copy_data_block(get_data_block(data_block_idx), buffer.data());
+            append_data_block(inode, data_block_idx);
+            inode->size += read_block_size;
+            statistics.bytes_written += read_block_size;
+            if(read_block_size < block_size)
+                return;
+        }
+    }
+
+    bool is_inline(INode *inode){
+        return inode->flags & INODE_INLINE;
+    }
+
+    u_int8_t *get_inline_data(INode *inode){
+        return (u_int8_t*)&inode->extent_header;
+    }
+
+    void read_file_inline(INode *inode, int file_descriptor, u_int64_t size){
+        inode->flags |= INODE_INLINE;
+        read_range(file_descriptor, get_inline_data(inode), size, 0);
+        inode->size = size;
+        mark_dirty_inode(inode);
+        statistics.bytes_written += size;
+    }
+
+    void move_inline_data_to_block(INode *inode){
+        u_int8_t data[INODE_INLINE_SIZE];
+        u_int64_t size = inode->size;
+        memcpy(data, get_inline_data(inode), size);
+        memset(get_inline_data(inode), 0, INODE_INLINE_SIZE);
+        inode->flags &= ~INODE_INLINE;
+        inode->size = 0;
+        inode->blocks_count = 0;
+        if(size > 0){
+            u_int64_t data_block_idx = get_empty_data_block();
+            memcpy(get_data_block(data_block_idx), data, size);
+            append_data_block(inode, data_block_idx);
+            inode->size = size;
+        }
+        mark_dirty_inode(inode);
+    }
+
+    void inode_to_file(INode *file, const std::string &file_name_destination){
+        int file_descriptor = ::open(file_name_destination.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if(file_descriptor < 0){
+            std::cout << "Cannot open file";
+            exit(EXIT_FAILURE);
+        }
+        if(is_inline(file))
+            write_range(file_descriptor, get_inline_data(file), file->size, 0);
+        u_int64_t file_offset = is_inline(file) ? file->size : 0;
+        std::vector<BlockRequest> requests;
+        for_each_extent(file, [&](Extent &extent){
+            u_int64_t current_size = std::min(file->size - file_offset, extent.length * block_size);
+            if(open_mode == OpenMode::CACHE_MODE)
+                copy_cached_blocks(extent.data_block_index, current_size, file_descriptor, file_offset);
+            else if(open_mode == OpenMode::MMAP_MODE)
+                copy_mapped_blocks(extent.data_block_index, current_size, file_descriptor, file_offset, requests);
+            else if(open_mode == OpenMode::LAZY_MODE)
+                load_data_blocks(extent.data_block_index, (current_size + block_size - 1) / block_size);
+            if(open_mode == OpenMode::STREAM_MODE || open_mode == OpenMode::LAZY_MODE)
+                requests.push_back({file_descriptor, get_data_block(extent.data_block_index), current_size, file_offset, true});
+            file_offset += current_size;
+            return file_offset < file->size;
+        });
+        block_transfer.run(requests);
+        statistics.bytes_read += file_offset;
+        if(::close(file_descriptor) < 0){
+            std::cout << "Writing to file error";
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    void copy_cached_blocks(u_int64_t data_block_idx, u_int64_t size, int file_descriptor, u_int64_t file_offset){
+        for(u_int64_t done = 0; done < size;){
+            u_int64_t current_size = std::min(block_size, size - done);
+            u_int8_t *dirty_block = block_cache.get_dirty(data_block_idx + done / block_size);
+            if(dirty_block){
+                write_range(file_descriptor, dirty_block, current_size, file_offset + done);
+                done += current_size;
+                continue;
+            }
+            while(done + current_size < size && !block_cache.get_dirty(data_block_idx + (done + current_size) / block_size))
+                current_size += std::min(block_size, size - done - current_size);
+            copy_range(image_descriptor, get_data_block_offset(data_block_idx) + done, file_descriptor, file_offset + done, current_size);
+            done += current_size;
+        }
+    }
+
+    void inode_to_directory(INode *direcotry_inode, const std::string &directory_name, std::set<INode*> &exported_directories, WorkerPool<FileExportJob> &workers){
+        std::error_code error;
+        std::filesystem::create_directories(directory_name, error);
+        if(error){
+            std::cout << "Cannot create directory: " << directory_name << "\n";
+            exit(EXIT_FAILURE);
+        }
+        if(!exported_directories.insert(direcotry_inode).second)
+            return;
+        for_each_data_block(direcotry_inode, [&](u_int64_t data_block_idx){
+            for_each_link_in_block(data_block_idx, [&](DirectoryLink *direcotry_link, u_int64_t){
+                if(!direcotry_link->used)
+                    return;
+                INode *inode = &inodes[direcotry_link->inode_id];
+                std::string file_name = directory_name + "/" + get_link_name(direcotry_link);
+                if(inode->type == INodeType::DIRECTORY_NODE)
+                    inode_to_directory(inode, file_name, exported_directories, workers);
+                else
+                    workers.push(FileExportJob{file_name, inode});
+            });
+            return true;
+        });
+    }
+
+    std::vector<std::filesystem::directory_entry> get_host_entries(const std::string &directory_name){
+        std::vector<std::filesystem::directory_entry> entries;
+        for(auto &entry : std::filesystem::directory_iterator(directory_name))
+            entries.push_back(entry);
+        std::sort(entries.begin(), entries.end());
+        return entries;
+    }
+
+    void check_host_directory(INode *direcotry_inode, const std::string &directory_name, u_int64_t &blocks_count){
+        for(auto &entry : get_host_entries(directory_name)){
+            std::string file_name = entry.path().filename().string();
+            if(!is_valid_name(file_name)){
+                std::cerr << "Invalid file name: " << entry.path().string() << "\n";
+                exit(EXIT_FAILURE);
+            }
+            INode *inode = direcotry_inode ? get_inode_in_inode(direcotry_inode, file_name) : NULL;
+            if(entry.is_directory() && !entry.is_symlink()){
+                if(inode && inode->type != INodeType::DIRECTORY_NODE){
+                    std::cerr << "FIle alraedy exists";
+                    exit(EXIT_FAILURE);
+                }
+                check_host_directory(inode, entry.path().string(), blocks_count);
+            } else if(entry.is_regular_file()){
+                if(inode){
+                    std::cerr << "FIle alraedy exists";
+                    exit(EXIT_FAILURE);
+                }
+                if(entry.file_size() > INODE_INLINE_SIZE)
+                    blocks_count += (entry.file_size() + block_size - 1) / block_size;
+            }
+        }
+    }
+
+    void directory_to_inode(INode *direcotry_inode, const std::string &directory_name, std::vector<FileCopyJob> &jobs){
+        for(auto &entry : get_host_entries(directory_name)){
+            std::string file_name = entry.path().filename().string();
+            INode *inode = get_inode_in_inode(direcotry_inode, file_name);
+            if(entry.is_directory() && !entry.is_symlink()){
+                if(inode){
+                    directory_to_inode(inode, entry.path().string(), jobs);
+                    continue;
+                }
+                inode = create_inode_in_directory(direcotry_inode, file_name, INodeType::DIRECTORY_NODE);
+                directory_to_inode(inode, entry.path().string(), jobs);
+            } else if(entry.is_regular_file()){
+                u_int64_t size = entry.file_size();
+                inode = create_inode_in_directory(direcotry_inode, file_name, INodeType::FILE_NODE);
+                if(size > INODE_INLINE_SIZE){
+                    jobs.push_back(FileCopyJob{entry.path().string(), size, allocate_file_blocks(size), inode});
+                    continue;
+                }
+                int file_descriptor = ::open(entry.path().c_str(), O_RDONLY);
+                if(file_descriptor < 0){
+                    std::cout << "Cannot open file";
+                    exit(EXIT_FAILURE);
+                }
+                read_file_inline(inode, file_descriptor, size);
+                ::close(file_descriptor);
+            }
+        }
+    }
+
+    INode* create_inode_in_directory(INode *direcotry_inode, std::string_view name, INodeType type){
+        u_int64_t new_inode_idx = get_empty_inode();
+        INode *inode = &inodes[new_inode_idx];
+        inode->reference_count = 1;
+        inode->type = type;
+        mark_dirty_inode(inode);
+        link_inode_in_directory(direcotry_inode, name, new_inode_idx);
+        return inode;
+    }
+
+    void link_inode_in_directory(INode *direcotry_inode, std::string_view name, u_int64_t inode_idx){
+        DirectoryLink new_link{};
+        new_link.used = true;
+        new_link.inode_id = inode_idx;
+        set_link_name(&new_link, name);
+        add_link_to_inode(direcotry_inode, new_link);
+    }
+
+    void convert_directory_v1(DiscV1Reader &old_disc, INodeV1 *old_directory, INode *direcotry_inode, std::unordered_map<u_int64_t, u_int64_t> &converted_inodes){
+        old_disc.for_each_link(old_directory, [&](DirectoryLinkV1 *old_link){
+            std::string link_name((char*)old_link->name, strnlen((char*)old_link->name, NAME_LENGTH));
+            auto converted = converted_inodes.find(old_link->inode_id);
+            if(converted != converted_inodes.end())
+                return link_inode_in_directory(direcotry_inode, link_name, converted->second);
+            INodeV1 *old_inode = &old_disc.inodes[old_link->inode_id];
+            INode *inode = create_inode_in_directory(direcotry_inode, link_name, (INodeType)old_inode->type);
+            inode->reference_count = old_inode->reference_count;
+            converted_inodes[old_link->inode_id] = inode - inodes;
+            if(old_inode->type == INodeType::DIRECTORY_NODE)
+                return convert_directory_v1(old_disc, old_inode, inode, converted_inodes);
+            if(old_inode->size <= INODE_INLINE_SIZE){
+                inode->flags |= INODE_INLINE;
+                inode->size = old_inode->size;
+                old_disc.for_each_data_block(old_inode, [&](DataBlockV1 *old_block){
+                    memcpy(get_inline_data(inode), old_block->data, inode->size);
+                    return false;
+                });
+                return;
+            }
+            std::vector<u_int64_t> new_data_blocks = allocate_file_blocks(old_inode->size);
+            u_int64_t file_block = 0;
+            old_disc.for_each_data_block(old_inode, [&](DataBlockV1 *old_block){
+                u_int64_t current_size = std::min(block_size, old_inode->size - file_block * block_size);
+                if(current_size == block_size)
+                    copy_data_block(get_data_block(new_data_blocks[file_block]), old_block->data);
+                else
+                    memcpy(get_data_block(new_data_blocks[file_block]), old_block->data, current_size);
+                release_blocks();
+                return ++file_block < new_data_blocks.size();
+            });
+            if(file_block < new_data_blocks.size()){
+                std::cerr << "Invalid disc file";
+                exit(EXIT_FAILURE);
+            }
+            attach_file_blocks(inode, new_data_blocks, old_inode->size);
+        });
+    }
+
+    std::vector<u_int64_t> allocate_file_blocks(u_int64_t size){
+        u_int64_t blocks_count = (size + block_size - 1) / block_size;
+        std::vector<u_int64_t> new_data_blocks;
+        for(u_int64_t idx = 0; idx < blocks_count; idx++)
+            new_data_blocks.push_back(get_empty_data_block(false));
+        if(size % block_size){
+            u_int64_t last_block_size = size % block_size;
+            memset(get_data_block(new_data_blocks.back()) + last_block_size, 0, block_size - last_block_size);
+        }
+        return new_data_blocks;
+    }
+
+    void attach_file_blocks(INode *inode, const std::vector<u_int64_t> &data_blocks, u_int64_t size){
+        for(auto data_block_idx : data_blocks)
+            append_data_block(inode, data_block_idx);
+        inode->size = size;
+        mark_dirty_inode(inode);
+    }
+
+    void copy_mapped_blocks(u_int64_t data_block_idx, u_int64_t size, int file_descriptor, u_int64_t file_offset, std::vector<BlockRequest> &requests){
+        for(u_int64_t done = 0; done < size;){
+            bool dirty = dirty_data_blocks.count(data_block_idx + done / block_size);
+            u_int64_t current_size = std::min(block_size, size - done);
+            while(done + current_size < size && dirty == (bool)dirty_data_blocks.count(data_block_idx + (done + current_size) / block_size))
+                current_size += std::min(block_size, size - done - current_size);
+            if(dirty)
+                requests.push_back({file_descriptor, get_data_block(data_block_idx) + done, current_size, file_offset + done, true});
+            else
+                copy_range(image_descriptor, get_data_block_offset(data_block_idx) + done, file_descriptor, file_offset + done, current_size);
+            done += current_size;
+        }
+    }
+    void copy_file_blocks(int file_descriptor, const std::vector<u_int64_t> &file_data_blocks, u_int64_t size){
+        u_int64_t file_offset = 0;
+        std::vector<BlockRequest> requests;
+        for(u_int64_t first = 0; first < file_data_blocks.size();){
+            u_int64_t last = first + 1;
+            while(last < file_data_blocks.size() && file_data_blocks[last] == file_data_blocks[last - 1] + 1)
+                last++;
+            u_int64_t current_size = std::min((last - first) * block_size, size - file_offset);
+            if(open_mode == OpenMode::CACHE_MODE)
+                copy_file_to_cache(file_descriptor, file_data_blocks[first], current_size, file_offset);
+            else if(open_mode == OpenMode::MMAP_MODE)
+                copy_file_to_mapping(file_descriptor, file_data_blocks[first], current_size, file_offset, requests);
+            else{
+                if(open_mode == OpenMode::LAZY_MODE)
+                    set_blocks_loaded(file_data_blocks[first], last - first);
+                requests.push_back({file_descriptor, get_data_block(file_data_blocks[first]), current_size, file_offset, false});
+            }
+            file_offset += current_size;
+            first = last;
+        }
+        block_transfer.run(requests);
+        statistics.bytes_written += size;
+    }
+
+    void copy_file_to_cache(int file_descriptor, u_int64_t data_block_idx, u_int64_t size, u_int64_t file_offset){
+        for(u_int64_t done = 0; done < size;){
+            u_int64_t idx = data_block_idx + done / block_size;
+            u_int64_t current_size = std::min(block_size, size - done);
+            if(current_size < block_size || is_map_bit_set(committed_data_maps.data(), idx)){
+                read_range(file_descriptor, get_data_block(idx), current_size, file_offset + done);
+                mark_dirty_data_block(idx);
+                block_cache.unpin(idx);
+                done += current_size;
+                continue;
+            }
+            while(done + current_size + block_size <= size && !is_map_bit_set(committed_data_maps.data(), idx + current_size / block_size))
+                current_size += block_size;
+            block_cache.discard(idx, current_size / block_size);
+            copy_range(file_descriptor, file_offset + done, image_descriptor, get_data_block_offset(idx), current_size);
+            done += current_size;
+        }
+    }
+
+    void copy_file_to_mapping(int file_descriptor, u_int64_t data_block_idx, u_int64_t size, u_int64_t file_offset, std::vector<BlockRequest> &requests){
+        u_int64_t page_size = sysconf(_SC_PAGESIZE);
+        for(u_int64_t done = 0; done < size;){
+            u_int64_t idx = data_block_idx + done / block_size;
+            u_int64_t current_size = 0;
+            if(get_data_block_offset(idx) % page_size == 0)
+                while(done + current_size + block_size <= size && !is_map_bit_set(committed_data_maps.data(), idx + current_size / block_size))
+                    current_size += block_size;
+            current_size -= current_size % page_size;
+            if(current_size == 0){
+                current_size = std::min(block_size, size - done);
+                requests.push_back({file_descriptor, get_data_block(idx), current_size, file_offset + done, false});
+                done += current_size;
+                continue;
+            }
+            if(madvise(get_data_block(idx), current_size, MADV_DONTNEED) < 0){
+                std::cout << "Cannot map file";
+                exit(EXIT_FAILURE);
+            }
+            copy_range(file_descriptor, file_offset + done, image_descriptor, get_data_block_offset(idx), current_size);
+            dirty_data_blocks.erase(dirty_data_blocks.lower_bound(idx), dirty_data_blocks.lower_bound(idx + current_size / block_size));
+            done += current_size;
+        }
+    }
+    void copy_range(int source, u_int64_t source_offset, int destination, u_int64_t destination_offset, u_int64_t size){
+        loff_t source_position = source_offset;
+        loff_t destination_position = destination_offset;
+        while(size > 0){
+            ssize_t copied = copy_file_range(source, &source_position, destination, &destination_position, size, 0);
+            if(copied < 0 && (errno == EXDEV || errno == EINVAL || errno == ENOSYS || errno == EOPNOTSUPP)){
+                off_t sendfile_position = source_position;
+                if(lseek(destination, destination_position, SEEK_SET) < 0)
+                    copied = -1;
+                else
+                    copied = sendfile(destination, source, &sendfile_position, size);
+                if(copied > 0){
+                    source_position += copied;
+                    destination_position += copied;
+                }
+            }
+            if(copied <= 0){
+                std::cerr << "Invalid file";
+                exit(EXIT_FAILURE);
+            }
+            size -= copied;
+        }
+    }
+
+    void write_range(int descriptor, const void *buffer, u_int64_t size, u_int64_t offset){
+        const u_int8_t *bytes = (const u_int8_t*)buffer;
+        while(size > 0){
+            ssize_t written = pwrite(descriptor, bytes, size, offset);
+            if(written <= 0){
+                std::cout << "Writing to file error";
+                exit(EXIT_FAILURE);
+            }
+            bytes += written;
+            size -= written;
+            offset += written;
+        }
+    }
+
+    void read_range(int descriptor, void *buffer, u_int64_t size, u_int64_t offset){
+        u_int8_t *bytes = (u_int8_t*)buffer;
+        while(size > 0){
+            ssize_t read_size = pread(descriptor, bytes, size, offset);
+            if(read_size <= 0){
+                std::cerr << "Invalid file";
+                exit(EXIT_FAILURE);
+            }
+            bytes += read_size;
+            size -= read_size;
+            offset += read_size;
+        }
+    }
+
+    void for_each_dirty_range(const std::set<u_int64_t> &dirty, std::function<void(u_int64_t, u_int64_t)> write){
+        auto it = dirty.begin();
+        while(it != dirty.end()){
+            u_int64_t start = *it;
+            u_int64_t count = 1;
+            for(++it; it != dirty.end() && *it == start + count; ++it)
+                count++;
+            write(start, count);
+        }
+    }
+
+    void mark_dirty_inode(INode *inode){
+        dirty_inodes.insert(inode - inodes);
+    }
+
+    void mark_dirty_data_block(u_int64_t data_block_idx){
+        if(open_mode == OpenMode::CACHE_MODE)
+            block_cache.mark_dirty(data_block_idx);
+        else
+            dirty_data_blocks.insert(data_block_idx);
+    }
+
+    u_int8_t *get_data_block(u_int64_t data_block_idx){
+        if(open_mode == OpenMode::CACHE_MODE)
+            return block_cache.get(data_block_idx);
+        if(open_mode == OpenMode::LAZY_MODE && !is_block_loaded(data_block_idx))
+            load_data_blocks(data_block_idx, 1);
+        return data_blocks + data_block_idx * block_size;
+    }
+
+    bool is_block_loaded(u_int64_t data_block_idx){
+        return (__atomic_load_n(&loaded_maps[data_block_idx / MAP_WORD_BITS], __ATOMIC_ACQUIRE) >> (data_block_idx % MAP_WORD_BITS)) & 1;
+    }
+
+    void set_blocks_loaded(u_int64_t data_block_idx, u_int64_t count){
+        std::lock_guard<std::mutex> lock(load_mutex);
+        for(u_int64_t idx = data_block_idx; idx < data_block_idx + count; idx++)
+            __atomic_fetch_or(&loaded_maps[idx / MAP_WORD_BITS], 1ull << (idx % MAP_WORD_BITS), __ATOMIC_RELEASE);
+    }
+
+    void load_data_blocks(u_int64_t data_block_idx, u_int64_t count){
+        std::lock_guard<std::mutex> lock(load_mutex);
+        for(u_int64_t first = data_block_idx; first < data_block_idx + count;){
+            if(is_block_loaded(first)){
+                first++;
+                continue;
+            }
+            u_int64_t last = first + 1;
+            while(last < data_block_idx + count && !is_block_loaded(last))
+                last++;
+            read_range(image_descriptor, data_blocks + first * block_size, (last - first) * block_size, get_data_block_offset(first));
+            for(u_int64_t idx = first; idx < last; idx++)
+                __atomic_fetch_or(&loaded_maps[idx / MAP_WORD_BITS], 1ull << (idx % MAP_WORD_BITS), __ATOMIC_RELEASE);
+            statistics.lazy_loads += last - first;
+            first = last;
+        }
+    }
+
+    u_int64_t get_data_block_idx(DirectoryLink *directory_link){
+        if(open_mode == OpenMode::CACHE_MODE)
+            return block_cache.get_data_block_idx(directory_link);
+        return ((u_int8_t*)directory_link - data_blocks) / block_size;
+    }
+
+    template<u_int64_t BlockSize>
+    static void clear_block(u_int8_t *block){
+        memset(block, 0, BlockSize);
+    }
+
+    template<u_int64_t BlockSize>
+    static void copy_block(u_int8_t *destination, const u_int8_t *source){
+        memcpy(destination, source, BlockSize);
+    }
+
+    void clear_data_block(u_int8_t *block){
+        switch(block_size){
+            case 4096: return clear_block<4096>(block);
+            case 8192: return clear_block<8192>(block);
+            case 65536: return clear_block<65536>(block);
+            case 1 << 20: return clear_block<1 << 20>(block);
+            default: memset(block, 0, block_size);
+        }
+    }
+
+    void copy_data_block(u_int8_t *destination, const u_int8_t *source){
+        switch(block_size){
+            case 4096: return copy_block<4096>(destination, source);
+            case 8192: return copy_block<8192>(destination, source);
+            case 65536: return copy_block<65536>(destination, source);
+            case 1 << 20: return copy_block<1 << 20>(destination, source);
+            default: memcpy(destination, source, block_size);
+        }
+    }
+
+    template<u_int64_t LinkSize, typename Visit>
+    void scan_links(u_int8_t *block, Visit &visit){
+        for(u_int64_t idx = 0; idx < links_in_block; idx++)
+            visit((DirectoryLink*)(block + idx * (LinkSize ? LinkSize : link_size)), idx);
+    }
+
+    template<typename Visit>
+    void for_each_link_in_block(u_int64_t data_block_idx, Visit visit){
+        u_int8_t *block = get_data_block(data_block_idx);
+        statistics.directory_entries_scanned += links_in_block;
+        switch(link_size){
+            case LINK_SIZE(16): return scan_links<LINK_SIZE(16)>(block, visit);
+            case LINK_SIZE(32): return scan_links<LINK_SIZE(32)>(block, visit);
+            case LINK_SIZE(64): return scan_links<LINK_SIZE(64)>(block, visit);
+            default: return scan_links<0>(block, visit);
+        }
+    }
+
+    bool is_map_bit_set(u_int64_t *map, u_int64_t idx){
+        return (map[idx / MAP_WORD_BITS] >> (idx % MAP_WORD_BITS)) & 1;
+    }
+
+    bool set_map_bit(u_int64_t *map, u_int64_t idx, bool used){
+        if(is_map_bit_set(map, idx) == used)
+            return false;
+        u_int64_t bit = (u_int64_t)1 << (idx % MAP_WORD_BITS);
+        if(used)
+            map[idx / MAP_WORD_BITS] |= bit;
+        else
+            map[idx / MAP_WORD_BITS] &= ~bit;
+        return true;
+    }
+
+    u_int64_t find_empty_bit(u_int64_t *map, u_int64_t bits, u_int32_t &cursor, const u_int64_t *excluded = NULL){
+        u_int64_t words = MAP_WORDS(bits);
+        for(u_int64_t step = 0; step < words; step++){
+            u_int64_t word_idx = (cursor + step) % words;
+            u_int64_t free_bits = ~map[word_idx];
+            if(excluded)
+                free_bits &= ~excluded[word_idx];
+            if(word_idx == words - 1 && bits % MAP_WORD_BITS)
+                free_bits &= ((u_int64_t)1 << (bits % MAP_WORD_BITS)) - 1;
+            if(!free_bits)
+                continue;
+            cursor = word_idx;
+            return word_idx * MAP_WORD_BITS + __builtin_ctzll(free_bits);
+        }
+        return -1;
+    }
+
+    bool is_data_block_used(u_int64_t data_block_idx){
+        return is_map_bit_set(data_maps, data_block_idx);
+    }
+
+    void set_data_map(u_int64_t data_block_idx, bool used){
+        if(!set_map_bit(data_maps, data_block_idx, used))
+            return;
+        if(used)
+            super_block.unused_datablocks -= 1;
+        else
+            super_block.unused_datablocks += 1;
+        dirty_data_maps.insert(data_block_idx / MAP_WORD_BITS);
+    }
+
+    void set_inode_map(u_int64_t inode_idx, bool used){
+        if(!set_map_bit(inode_maps, inode_idx, used))
+            return;
+        if(used)
+            super_block.unused_inodes -= 1;
+        else
+            super_block.unused_inodes += 1;
+        dirty_inode_maps.insert(inode_idx / MAP_WORD_BITS);
+    }
+
+    bool is_valid_name(std::string_view name){
+        if(name.length() >= name_length or name == "." or name == ".." or name == "/")
+            return false;
+        return true;
+    }
+
+    INode* get_inode_by_pwd(std::string_view pwd){
+        std::string_view path, file_name;
+        split_parent(pwd, path, file_name);
+        INode *direcotry_inode = get_direcotry_inode(path);
+        if(!direcotry_inode){
+            std::cerr << "Invalid path";
+            exit(EXIT_FAILURE);
+        }
+        INode *file= get_inode_in_inode(direcotry_inode, file_name);
+        if(!file){
+            std::cerr << "Missing file";
+            exit(EXIT_FAILURE);
+        }
+        return file;
+    }
+
+    u_int32_t get_empty_inode(){
+        u_int64_t i = super_block.unused_inodes ? find_empty_bit(inode_maps, inodes_length, super_block.inode_map_cursor) : -1;
+        if(i != (u_int64_t)-1){
+            set_inode_map(i, true);
+            inodes[i] = INode{};
+            statistics.inode_allocations++;
+            return i;
+        }
+        std::cerr << "Lack of empty inodes\n";
+        exit(EXIT_FAILURE);
+        return -1;
+    }
+
+    u_int32_t get_empty_data_block(bool clear = true){
+        u_int64_t i = super_block.unused_datablocks ? find_empty_bit(data_maps, data_blocks_length, super_block.data_map_cursor, frozen_maps.empty() ? NULL : frozen_maps.data()) : -1;
+        if(i != (u_int64_t)-1){
+            set_data_map(i, true);
+            if(clear)
+                clear_data_block(get_data_block(i));
+            mark_dirty_data_block(i);
+            statistics.data_block_allocations++;
+            return i;
+        }
+        std::cerr << "Lack of empty data blokcs\n";
+        exit(EXIT_FAILURE);
+        return -1;
+    }
+
+    INode* get_inode_in_inode(INode *direcotry, std::string_view name){
+        if(name.empty())
+            return direcotry;
+        DirectoryLink *directory_link = get_direcotry_in_inode(direcotry, name);
+        if(!directory_link)
+            return NULL;
+        return &inodes[directory_link->inode_id];
+    }
+
+    DirectoryLink *get_direcotry_in_inode(INode *direcotry, std::string_view name){
+        if(direcotry->type != INodeType::DIRECTORY_NODE)
+            return NULL;
+        DirectoryIndex &index = get_directory_index(direcotry);
+        statistics.directory_entries_scanned++;
+        auto found = find_link(index, name);
+        if(found == index.links.end())
+            return NULL;
+        return get_directory_link(found->second);
+    }
+
+    std::unordered_multimap<size_t, u_int64_t>::iterator find_link(DirectoryIndex &index, std::string_view name){
+        auto range = index.links.equal_range(std::hash<std::string_view>()(name));
+        for(auto it = range.first; it != range.second; it++)
+            if(get_link_name_view(get_directory_link(it->second)) == name)
+                return it;
+        return index.links.end();
+    }
+
+    DirectoryLink *get_directory_link(u_int64_t position){
+        return (DirectoryLink*)(get_data_block(position / links_in_block) + position % links_in_block * link_size);
+    }
+
+    void set_link_name(DirectoryLink *directory_link, std::string_view name){
+        memset(directory_link->name, 0, name_length);
+        memcpy(directory_link->name, name.data(), std::min<size_t>(name.size(), name_length));
+    }
+
+    std::string get_link_name(DirectoryLink *directory_link){
+        return std::string(get_link_name_view(directory_link));
+    }
+
+    std::string_view get_link_name_view(DirectoryLink *directory_link){
+        return std::string_view((char*)directory_link->name, strnlen((char*)directory_link->name, name_length));
+    }
+
+    DirectoryIndex &get_directory_index(INode *directory){
+        auto found = directory_indexes.find(directory - inodes);
+        if(found != directory_indexes.end())
+            return found->second;
+        DirectoryIndex &index = directory_indexes[directory - inodes];
+        for_each_data_block(directory, [&](u_int64_t data_block_idx){
+            for_each_link_in_block(data_block_idx, [&](DirectoryLink *direcotry_link, u_int64_t idx){
+                u_int64_t position = data_block_idx * links_in_block + idx;
+                if(direcotry_link->used)
+                    index.links.emplace(std::hash<std::string_view>()(get_link_name_view(direcotry_link)), position);
+                else
+                    index.free_links.push_back(position);
+            });
+            return true;
+        });
+        std::reverse(index.free_links.begin(), index.free_links.end());
+        return index;
+    }
+
+    void check_version(){
+        if(super_block.magic != DISC_MAGIC || super_block.version != DISC_VERSION){
+            std::cerr << "Unsupported disc format, convert it first";
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    void load_lengths(SuperBlock super_block_){
+        block_size = super_block_.block_size;
+        name_length = super_block_.name_length;
+        link_size = LINK_SIZE(name_length);
+        links_in_block = block_size / link_size;
+        extents_in_block = (block_size - sizeof(ExtentHeader)) / sizeof(Extent);
+        inodes_length = super_block_.inodes_count;
+        inode_maps_length = MAP_WORDS(super_block_.inodes_count);
+        data_maps_length = MAP_WORDS(super_block_.datablocks_count);
+        data_blocks_length = super_block_.datablocks_count;
+    }
+
+    void add_link_to_inode(INode* inode, DirectoryLink directory_link){
+        DirectoryIndex &index = get_directory_index(inode);
+        if(index.free_links.empty()){
+            u_int64_t new_data_block_idx = get_empty_data_block();
+            append_data_block(inode, new_data_block_idx);
+            for(u_int64_t idx = links_in_block; idx > 0; idx--)
+                index.free_links.push_back(new_data_block_idx * links_in_block + idx - 1);
+        }
+        if(is_shared_block(index.free_links.back() / links_in_block)){
+            unshare_directory(inode);
+            return add_link_to_inode(inode, directory_link);
+        }
+        u_int64_t position = index.free_links.back();
+        index.free_links.pop_back();
+        DirectoryLink *free_link = get_directory_link(position);
+        memcpy(free_link, &directory_link, link_size);
+        index.links.emplace(std::hash<std::string_view>()(get_link_name_view(free_link)), position);
+        mark_dirty_data_block(get_data_block_idx(free_link));
+    }
+
+    void remove_link_from_inode(INode* inode, std::string_view name){
+        DirectoryIndex &index = get_directory_index(inode);
+        auto found = find_link(index, name);
+        if(found == index.links.end())
+            return;
+        if(is_shared_block(found->second / links_in_block)){
+            unshare_directory(inode);
+            return remove_link_from_inode(inode, name);
+        }
+        DirectoryLink *direcotry_link = get_directory_link(found->second);
+        direcotry_link->inode_id = -1;
+        direcotry_link->used = false;
+        mark_dirty_data_block(get_data_block_idx(direcotry_link));
+        index.free_links.push_back(found->second);
+        index.links.erase(found);
+    }
+
+    void unshare_directory(INode *directory){
+        for(u_int64_t file_block = 0; file_block < directory->blocks_count; file_block++)
+            get_writable_file_block(directory, file_block);
+        directory_indexes.erase(directory - inodes);
+    }
+
+    Extent *find_extent(ExtentHeader *header, Extent *extents, u_int64_t file_block){
+        return std::upper_bound(extents, extents + header->count, file_block, [](u_int64_t block, const Extent &extent){
+            return block < extent.file_block;
+        }) - 1;
+    }
+
+    ExtentHeader *get_extent_node(u_int64_t data_block_idx){
+        statistics.extent_hops++;
+        return (ExtentHeader*)get_data_block(data_block_idx);
+    }
+
+    u_int64_t get_file_block(INode *inode, u_int64_t file_block){
+        if(file_block >= inode->blocks_count)
+            return -1;
+        ExtentHeader *header = &inode->extent_header;
+        Extent *extents = inode->extents;
+        while(true){
+            Extent *extent = find_extent(header, extents, file_block);
+            if(header->depth == 0)
+                return extent->data_block_index + (file_block - extent->file_block);
+            header = get_extent_node(extent->data_block_index);
+            extents = (Extent*)(header + 1);
+        }
+    }
+
+    bool for_each_extent(ExtentHeader *header, Extent *extents, std::function<bool(Extent&)> visit){
+        for(u_int64_t idx = 0; idx < header->count; idx++){
+            if(header->depth == 0){
+                if(!visit(extents[idx]))
+                    return false;
+                continue;
+            }
+            ExtentHeader *child = get_extent_node(extents[idx].data_block_index);
+            if(!for_each_extent(child, (Extent*)(child + 1), visit))
+                return false;
+        }
+        return true;
+    }
+
+    void for_each_extent(INode *inode, std::function<bool(Extent&)> visit){
+        if(is_inline(inode))
+            return;
+        for_each_extent(&inode->extent_header, inode->extents, visit);
+    }
+
+    void for_each_data_block(INode *inode, std::function<bool(u_int64_t)> visit){
+        for_each_extent(inode, [&](Extent &extent){
+            for(u_int64_t idx = 0; idx < extent.length; idx++)
+                if(!visit(extent.data_block_index + idx))
+                    return false;
+            return true;
+        });
+    }
+
+    u_int64_t new_extent_subtree(u_int32_t depth, u_int64_t file_block, u_int64_t data_block_idx){
+        u_int64_t node_idx = get_empty_data_block();
+        ExtentHeader *header = get_extent_node(node_idx);
+        Extent *extents = (Extent*)(header + 1);
+        header->depth = depth;
+        header->count = 1;
+        extents[0].file_block = file_block;
+        if(depth == 0){
+            extents[0].data_block_index = data_block_idx;
+            extents[0].length = 1;
+        } else
+            extents[0].data_block_index = new_extent_subtree(depth - 1, file_block, data_block_idx);
+        return node_idx;
+    }
+
+    bool append_extent(ExtentHeader *header, Extent *extents, u_int64_t capacity, u_int64_t file_block, u_int64_t data_block_idx){
+        if(header->depth == 0 && header->count > 0){
+            Extent &last = extents[header->count - 1];
+            if(last.file_block + last.length == file_block && last.data_block_index + last.length == data_block_idx){
+                last.length += 1;
+                return true;
+            }
+        }
+        if(header->depth > 0){
+            u_int64_t child_idx = extents[header->count - 1].data_block_index;
+            ExtentHeader *child = get_extent_node(child_idx);
+            if(append_extent(child, (Extent*)(child + 1), extents_in_block, file_block, data_block_idx)){
+                mark_dirty_data_block(child_idx);
+                return true;
+            }
+        }
+        if(header->count == capacity)
+            return false;
+        Extent &extent = extents[header->count];
+        extent.file_block = file_block;
+        if(header->depth == 0){
+            extent.data_block_index = data_block_idx;
+            extent.length = 1;
+        } else{
+            extent.data_block_index = new_extent_subtree(header->depth - 1, file_block, data_block_idx);
+            extent.length = 0;
+        }
+        header->count += 1;
+        return true;
+    }
+
+    void append_data_block(INode *inode, u_int64_t data_block_idx){
+        if(inode->blocks_count > 0)
+            get_writable_file_block(inode, inode->blocks_count - 1, false);
+        mark_dirty_inode(inode);
+        if(!append_extent(&inode->extent_header, inode->extents, INODE_EXTENTS, inode->blocks_count, data_block_idx)){
+            ExtentHeader *header = push_down_extent_root(inode);
+            append_extent(header, (Extent*)(header + 1), extents_in_block, inode->blocks_count, data_block_idx);
+        }
+        inode->blocks_count += 1;
+    }
+
+    ExtentHeader *push_down_extent_root(INode *inode){
+        u_int64_t node_idx = get_empty_data_block();
+        ExtentHeader *header = get_extent_node(node_idx);
+        *header = inode->extent_header;
+        memcpy(header + 1, inode->extents, sizeof(inode->extents));
+        inode->extent_header.depth += 1;
+        inode->extent_header.count = 1;
+        inode->extents[0].file_block = 0;
+        inode->extents[0].data_block_index = node_idx;
+        inode->extents[0].length = 0;
+        mark_dirty_inode(inode);
+        return header;
+    }
+
+    void place_extent(ExtentHeader *header, Extent *extents, const Extent &extent){
+        Extent *position = find_extent(header, extents, extent.file_block) + 1;
+        memmove(position + 1, position, (extents + header->count - position) * sizeof(Extent));
+        *position = extent;
+        header->count += 1;
+    }
+
+    bool insert_extent(ExtentHeader *header, Extent *extents, u_int64_t capacity, Extent &extent){
+        if(header->depth > 0){
+            Extent *parent = find_extent(header, extents, extent.file_block);
+            ExtentHeader *child = get_extent_node(parent->data_block_index);
+            mark_dirty_data_block(parent->data_block_index);
+            if(!insert_extent(child, (Extent*)(child + 1), extents_in_block, extent))
+                return false;
+        }
+        if(header->count < capacity){
+            place_extent(header, extents, extent);
+            return false;
+        }
+        if(capacity != extents_in_block)
+            return true;
+        u_int64_t sibling_idx = get_empty_data_block();
+        ExtentHeader *sibling = get_extent_node(sibling_idx);
+        Extent *sibling_extents = (Extent*)(sibling + 1);
+        sibling->depth = header->depth;
+        sibling->count = header->count / 2;
+        header->count -= sibling->count;
+        memcpy(sibling_extents, extents + header->count, sibling->count * sizeof(Extent));
+        if(extent.file_block < sibling_extents[0].file_block)
+            place_extent(header, extents, extent);
+        else
+            place_extent(sibling, sibling_extents, extent);
+        extent = Extent{sibling_extents[0].file_block, sibling_idx, 0};
+        return true;
+    }
+
+    void insert_file_extent(INode *inode, Extent extent){
+        mark_dirty_inode(inode);
+        if(insert_extent(&inode->extent_header, inode->extents, INODE_EXTENTS, extent)){
+            ExtentHeader *header = push_down_extent_root(inode);
+            place_extent(header, (Extent*)(header + 1), extent);
+        }
+    }
+
+    bool is_shared_block(u_int64_t data_block_idx){
+        return (!frozen_maps.empty() && is_map_bit_set(frozen_maps.data(), data_block_idx)) || find_shared_extent(data_block_idx) != shared_references.end();
+    }
+
+    u_int64_t copy_shared_block(u_int64_t data_block_idx){
+        u_int64_t copy_idx = get_empty_data_block(false);
+        copy_data_block(get_data_block(copy_idx), get_data_block(data_block_idx));
+        release_data_block(data_block_idx);
+        return copy_idx;
+    }
+
+    u_int64_t get_writable_file_block(INode *inode, u_int64_t file_block, bool copy_data = true){
+        if(frozen_maps.empty() && !(inode->flags & INODE_SHARED))
+            return get_file_block(inode, file_block);
+        if(inode->flags & INODE_SHARED)
+            load_shared_references();
+        ExtentHeader *header = &inode->extent_header;
+        Extent *extents = inode->extents;
+        u_int64_t node_idx = -1;
+        auto mark_dirty_node = [&](){
+            if(node_idx == (u_int64_t)-1)
+                mark_dirty_inode(inode);
+            else
+                mark_dirty_data_block(node_idx);
+        };
+        while(header->depth > 0){
+            Extent *extent = find_extent(header, extents, file_block);
+            if(is_shared_block(extent->data_block_index)){
+                extent->data_block_index = copy_shared_block(extent->data_block_index);
+                mark_dirty_node();
+            }
+            node_idx = extent->data_block_index;
+            header = get_extent_node(node_idx);
+            extents = (Extent*)(header + 1);
+        }
+        Extent *extent = find_extent(header, extents, file_block);
+        u_int64_t offset = file_block - extent->file_block;
+        u_int64_t data_block_idx = extent->data_block_index + offset;
+        if(!copy_data || !is_shared_block(data_block_idx))
+            return data_block_idx;
+        u_int64_t copy_idx = copy_shared_block(data_block_idx);
+        mark_dirty_node();
+        Extent right{file_block + 1, data_block_idx + 1, extent->length - offset - 1};
+        if(offset > 0){
+            extent->length = offset;
+            insert_file_extent(inode, Extent{file_block, copy_idx, 1});
+        } else if(extent != extents && extent[-1].file_block + extent[-1].length == file_block && extent[-1].data_block_index + extent[-1].length == copy_idx){
+            extent[-1].length += 1;
+            *extent = right;
+            if(right.length == 0){
+                memmove(extent, extent + 1, (extents + header->count - extent - 1) * sizeof(Extent));
+                header->count -= 1;
+            }
+            return copy_idx;
+        } else{
+            extent->data_block_index = copy_idx;
+            extent->length = 1;
+        }
+        if(right.length > 0)
+            insert_file_extent(inode, right);
+        return copy_idx;
+    }
+
+    void for_each_extent_range(ExtentHeader *header, Extent *extents, std::function<void(u_int64_t, u_int64_t)> visit){
+        for(u_int64_t idx = 0; idx < header->count; idx++){
+            if(header->depth == 0){
+                visit(extents[idx].data_block_index, extents[idx].length);
+                continue;
+            }
+            visit(extents[idx].data_block_index, 1);
+            ExtentHeader *child = get_extent_node(extents[idx].data_block_index);
+            for_each_extent_range(child, (Extent*)(child + 1), visit);
+        }
+    }
+
+    void load_shared_references(){
+        if(shared_references_loaded)
+            return;
+        shared_references.clear();
+        std::vector<std::pair<u_int64_t, int>> bounds;
+        std::vector<INode*> shared_inodes;
+        for(u_int64_t word_idx = 0; word_idx < inode_maps_length; word_idx++)
+            for(u_int64_t used = inode_maps[word_idx]; used; used &= used - 1){
+                INode *inode = &inodes[word_idx * MAP_WORD_BITS + __builtin_ctzll(used)];
+                if(!(inode->flags & INODE_SHARED))
+                    continue;
+                shared_inodes.push_back(inode);
+                for_each_extent_range(&inode->extent_header, inode->extents, [&](u_int64_t data_block_idx, u_int64_t length){
+                    bounds.emplace_back(data_block_idx, 1);
+                    bounds.emplace_back(data_block_idx + length, -1);
+                });
+            }
+        std::sort(bounds.begin(), bounds.end());
+        u_int32_t references = 0;
+        for(u_int64_t idx = 0; idx < bounds.size(); idx++){
+            references += bounds[idx].second;
+            u_int64_t end = idx + 1 < bounds.size() ? bounds[idx + 1].first : bounds[idx].first;
+            if(references >= 2 && end > bounds[idx].first)
+                shared_references[bounds[idx].first] = SharedExtent{end - bounds[idx].first, references};
+        }
+        for(auto inode : shared_inodes){
+            bool shared = false;
+            for_each_extent_range(&inode->extent_header, inode->extents, [&](u_int64_t data_block_idx, u_int64_t length){
+                auto found = shared_references.lower_bound(data_block_idx + length);
+                shared |= found != shared_references.begin() && std::prev(found)->first + std::prev(found)->second.length > data_block_idx;
+            });
+            if(!shared){
+                inode->flags &= ~INODE_SHARED;
+                mark_dirty_inode(inode);
+            }
+        }
+        shared_references_loaded = true;
+    }
+
+    std::map<u_int64_t, SharedExtent>::iterator find_shared_extent(u_int64_t data_block_idx){
+        auto found = shared_references.upper_bound(data_block_idx);
+        if(found == shared_references.begin() || std::prev(found)->first + std::prev(found)->second.length <= data_block_idx)
+            return shared_references.end();
+        return std::prev(found);
+    }
+
+    void split_shared_extent(u_int64_t data_block_idx){
+        auto found = find_shared_extent(data_block_idx);
+        if(found == shared_references.end() || found->first == data_block_idx)
+            return;
+        u_int64_t length = data_block_idx - found->first;
+        shared_references[data_block_idx] = SharedExtent{found->second.length - length, found->second.references};
+        found->second.length = length;
+    }
+
+    void add_shared_references(u_int64_t data_block_idx, u_int64_t length){
+        split_shared_extent(data_block_idx);
+        split_shared_extent(data_block_idx + length);
+        u_int64_t end = data_block_idx + length;
+        auto found = shared_references.lower_bound(data_block_idx);
+        for(u_int64_t idx = data_block_idx; idx < end;){
+            if(found != shared_references.end() && found->first == idx){
+                found->second.references += 1;
+                idx += found->second.length;
+                found++;
+                continue;
+            }
+            u_int64_t gap_end = found != shared_references.end() && found->first < end ? found->first : end;
+            shared_references[idx] = SharedExtent{gap_end - idx, 2};
+            idx = gap_end;
+        }
+    }
+
+    void release_data_blocks(u_int64_t data_block_idx, u_int64_t length){
+        if(shared_references.empty()){
+            for(u_int64_t idx = 0; idx < length; idx++)
+                set_data_map(data_block_idx + idx, false);
+            return;
+        }
+        split_shared_extent(data_block_idx);
+        split_shared_extent(data_block_idx + length);
+        u_int64_t end = data_block_idx + length;
+        auto found = shared_references.lower_bound(data_block_idx);
+        for(u_int64_t idx = data_block_idx; idx < end;){
+            if(found != shared_references.end() && found->first == idx){
+                idx += found->second.length;
+                found = --found->second.references < 2 ? shared_references.erase(found) : std::next(found);
+                continue;
+            }
+            set_data_map(idx++, false);
+        }
+    }
+
+    void release_data_block(u_int64_t data_block_idx){
+        release_data_blocks(data_block_idx, 1);
+    }
+
+    void free_extent(Extent &extent, u_int32_t depth, u_int64_t first_block){
+        if(depth == 0)
+            return release_data_blocks(extent.data_block_index + first_block, extent.length - first_block);
+        ExtentHeader *child = get_extent_node(extent.data_block_index);
+        Extent *extents = (Extent*)(child + 1);
+        for(u_int64_t idx = 0; idx < child->count; idx++)
+            free_extent(extents[idx], child->depth, 0);
+        release_data_block(extent.data_block_index);
+    }
+
+    void truncate_extents(ExtentHeader *header, Extent *extents, u_int64_t blocks_count){
+        while(header->count > 0){
+            Extent &last = extents[header->count - 1];
+            if(last.file_block >= blocks_count){
+                free_extent(last, header->depth, 0);
+                header->count -= 1;
+                continue;
+            }
+            if(header->depth == 0){
+                u_int64_t kept_length = blocks_count - last.file_block;
+                if(kept_length < last.length){
+                    free_extent(last, 0, kept_length);
+                    last.length = kept_length;
+                }
+            } else{
+                ExtentHeader *child = get_extent_node(last.data_block_index);
+                truncate_extents(child, (Extent*)(child + 1), blocks_count);
+                mark_dirty_data_block(last.data_block_index);
+            }
+            break;
+        }
+    }
+
+    void truncate_data_blocks(INode *inode, u_int64_t blocks_count){
+        if(blocks_count >= inode->blocks_count)
+            return;
+        if(inode->flags & INODE_SHARED)
+            load_shared_references();
+        if(blocks_count > 0)
+            get_writable_file_block(inode, blocks_count - 1, false);
+        truncate_extents(&inode->extent_header, inode->extents, blocks_count);
+        while(inode->extent_header.depth > 0 && inode->extent_header.count == 1){
+            u_int64_t child_idx = inode->extents[0].data_block_index;
+            ExtentHeader *child = get_extent_node(child_idx);
+            if(child->count > INODE_EXTENTS)
+                break;
+            inode->extent_header = *child;
+            memcpy(inode->extents, child + 1, child->count * sizeof(Extent));
+            release_data_block(child_idx);
+        }
+        if(inode->extent_header.count == 0)
+            inode->extent_header.depth = 0;
+        inode->blocks_count = blocks_count;
+        mark_dirty_inode(inode);
+    }
+
+    INode *get_direcotry_inode(std::string_view path){
+        INode *current_direcotry_inode = inodes;
+        size_t resolved = 0;
+        for(size_t end = path.size(); end > 0 && end != std::string_view::npos; end = path.rfind('/', end - 1)){
+            auto cached = path_cache.find(path.substr(0, end));
+            if(cached != path_cache.end()){
+                path_cache_entries.splice(path_cache_entries.begin(), path_cache_entries, cached->second);
+                current_direcotry_inode = &inodes[cached->second->second];
+                resolved = end;
+                break;
+            }
+        }
+        PathTokenizer tokenizer(path, resolved);
+        std::string_view current_directory_name;
+        while(tokenizer.next(current_directory_name)){
+            if(!is_valid_name(current_directory_name)){
+                std::cerr << "Invalid directory name: " << current_directory_name << "\n";
+                exit(EXIT_FAILURE);
+            }
+            INode* next_direcotry_inode = get_inode_in_inode(current_direcotry_inode, current_directory_name);
+            if(next_direcotry_inode && next_direcotry_inode->type == INodeType::DIRECTORY_NODE){
+                current_direcotry_inode = next_direcotry_inode;
+            } else{
+                std::cerr << "Missing directory: " << current_directory_name << "\n";
+                return NULL;
+            }
+            if(!current_directory_name.empty())
+                cache_path(path.substr(0, tokenizer.end()), current_direcotry_inode);
+        }
+        return current_direcotry_inode;
+    }
+
+    void cache_path(std::string_view path, INode *directory){
+        if(path_cache.count(path))
+            return;
+        if(path_cache_entries.size() >= PATH_CACHE_SIZE){
+            path_cache.erase(path_cache_entries.back().first);
+            path_cache_entries.pop_back();
+        }
+        path_cache_entries.emplace_front(path, directory - inodes);
+        path_cache[path_cache_entries.front().first] = path_cache_entries.begin();
+    }
+
+    u_int64_t get_size_inode(INode *direcotry){
+        u_int64_t size = 0;
+        for_each_data_block(direcotry, [&](u_int64_t data_block_idx){
+            for_each_link_in_block(data_block_idx, [&](DirectoryLink *direcotry_link, u_int64_t){
+                if(direcotry_link->used){
+                    if(std::find(shown_inodes.begin(),shown_inodes.end(), &inodes[direcotry_link->inode_id]) != shown_inodes.end())
+                        return;
+                    shown_inodes.push_back(&inodes[direcotry_link->inode_id]);
+                    if(inodes[direcotry_link->inode_id].type == INodeType::FILE_NODE)
+                        size += inodes[direcotry_link->inode_id].size;
+                    else
+                        size += get_size_inode(&inodes[direcotry_link->inode_id]);
+                }
+            });
+            return true;
+        });
+        return size;
+    }
+
+    void show_files_inode(INode* directory_inode, int rec_lvl){
+        if(directory_inode->type != INodeType::DIRECTORY_NODE)
+            return;
+        for_each_data_block(directory_inode, [&](u_int64_t data_block_idx){
+            std::cout << "\n";
+            for(int i = 0; i < rec_lvl; i++)
+                std::cout << "  ";
+            for_each_link_in_block(data_block_idx, [&](DirectoryLink *direcotry_link, u_int64_t){
+                if(!direcotry_link->used)
+                    return;
+                if(std::find(shown_direcotry_links.begin(),shown_direcotry_links.end(), direcotry_link) != shown_direcotry_links.end())
+                    return;
+                shown_direcotry_links.push_back(direcotry_link);
+                if (inodes[direcotry_link->inode_id].type == INodeType::DIRECTORY_NODE)
+                    std:: cout << "\x1B[34m" << get_link_name(direcotry_link) << "\033[0m ";
+                else
+                    std::cout << get_link_name(direcotry_link) << " ";
+                show_files_inode(&inodes[direcotry_link->inode_id], rec_lvl + 1);
+            });
+            std::cout << "\n";
+            for(int i = 0; i < rec_lvl - 1; i++)
+                std::cout << "  ";
+            return true;
+        });
+    }
+
+    void remove_inode(INode* inode){
+        inode->reference_count -= 1;
+        mark_dirty_inode(inode);
+        if(inode->reference_count != 0)
+            return;
+        if(inode->type == INodeType::DIRECTORY_NODE){
+            for_each_data_block(inode, [&](u_int64_t data_block_idx){
+                for_each_link_in_block(data_block_idx, [&](DirectoryLink *direcotry_link, u_int64_t){
+                    if(direcotry_link->used){
+                        remove_inode(&inodes[direcotry_link->inode_id]);
+                    }
+                });
+                return true;
+            });
+        }
+        truncate_data_blocks(inode, 0);
+        directory_indexes.erase(inode - inodes);
+        inode->type = INodeType::UNUSED_NODE;
+        inode->reference_count = 0;
+        mark_dirty_inode(inode);
+        set_inode_map(inode - inodes, false);
+    }
+
+    void split_parent(std::string_view pwd, std::string_view &parent, std::string_view &name){
+        size_t slash = pwd.rfind('/');
+        if(slash == std::string_view::npos){
+            parent = std::string_view();
+            name = pwd;
+        } else{
+            parent = pwd.substr(0, slash);
+            name = pwd.substr(slash + 1);
+        }
+    }
+};
+
+#endif